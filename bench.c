@@ -0,0 +1,579 @@
+/**
+ * Description: Benchmark of the huffman library. Generates synthetic corpora of a fixed size from a seed, so every
+ *  run compresses the same bytes, and measures the encode and decode throughput, the compression ratio and the
+ *  peak memory use of each. Every corpus runs in a process of its own, so the peak memory of one corpus is not
+ *  carried over to the next. The results are written as JSON so two runs can be compared with a diff.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "huffman.h"
+
+// CORPUS GENERATION
+// every corpus is generated from a xorshift64* sequence, the same seed always gives the same corpus
+#define DEFAULT_CORPUS_SIZE (16 * 1024 * 1024)
+#define DEFAULT_SEED 1
+#define MAX_RUN_LENGTH 4096
+
+typedef void (*CorpusGenerator)(unsigned char* buffer, size_t size, uint64_t* state);
+
+typedef struct Corpus {
+  const char* name;
+  CorpusGenerator generate;
+} Corpus;
+
+uint64_t nextRandom(uint64_t* state);
+void generateEnglish(unsigned char* buffer, size_t size, uint64_t* state);
+void generateUniform(unsigned char* buffer, size_t size, uint64_t* state);
+void generateSkewed(unsigned char* buffer, size_t size, uint64_t* state);
+void generateRuns(unsigned char* buffer, size_t size, uint64_t* state);
+
+static const char ALPHABET[] = HUFFMAN_ALPHABET;
+#define ALPHABET_SIZE (sizeof(ALPHABET) - 1)
+
+// the most common english words, roughly in order of frequency
+static const char* const WORDS[] = {
+  "the", "of", "and", "to", "a", "in", "is", "it", "you", "that", "he", "was", "for", "on", "are", "with", "as", "i",
+  "his", "they", "be", "at", "one", "have", "this", "from", "or", "had", "by", "not", "word", "but", "what", "some",
+  "we", "can", "out", "other", "were", "all", "there", "when", "up", "use", "your", "how", "said", "an", "each", "she",
+  "which", "do", "their", "time", "if", "will", "way", "about", "many", "then", "them", "write", "would", "like", "so",
+  "these", "her", "long", "make", "thing", "see", "him", "two", "has", "look", "more", "day", "could", "go", "come",
+  "did", "number", "sound", "no", "most", "people", "my", "over", "know", "water", "than", "call", "first", "who",
+  "may", "down", "side", "been", "now", "find", "compression", "huffman", "frequency", "table", "block", "decoder",
+};
+#define WORD_COUNT (sizeof(WORDS) / sizeof(WORDS[0]))
+
+static const Corpus CORPORA[] = {
+  { "english", generateEnglish }, // words of skewed frequency with case, punctuation, digits and line breaks
+  { "uniform", generateUniform }, // every encodable character equally likely, the worst case for the codes
+  { "skewed", generateSkewed }, // every character half as likely as the one before it
+  { "runs", generateRuns }, // long runs of the same character
+};
+#define CORPUS_COUNT (sizeof(CORPORA) / sizeof(CORPORA[0]))
+
+/**
+ * Function Name: nextRandom
+ * Purpose: Advances a xorshift64* generator
+ * Parameters:
+ *  - uint64_t* state: The state of the generator, never 0
+ * Return Value:
+ *  - uint64_t: the next random number
+ */
+uint64_t nextRandom(uint64_t* state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Function Name: generateEnglish
+ * Purpose: Fills a buffer with english like text. Words are picked with a bias towards the start of the word list,
+ *  sentences start with a capital and end in a period, and there are commas, numbers and line breaks in between.
+ * Parameters:
+ *  - unsigned char* buffer: The buffer to fill
+ *  - size_t size: The size of the buffer
+ *  - uint64_t* state: The random generator
+ * Return Value:
+ *  - void
+ */
+void generateEnglish(unsigned char* buffer, size_t size, uint64_t* state) {
+  size_t index = 0;
+  int sentence_start = 1;
+  int line_words = 0;
+
+  while (index < size) {
+    uint64_t random = nextRandom(state);
+    char word[32];
+
+    if (random % 40 == 0) {
+      snprintf(word, sizeof(word), "%u", (unsigned) (random >> 32) % 10000);
+    } else {
+      // the product of two uniform picks favors the first words, like the frequencies of real text
+      size_t pick = (size_t) ((random >> 8) % WORD_COUNT) * (size_t) ((random >> 24) % WORD_COUNT) / WORD_COUNT;
+      snprintf(word, sizeof(word), "%s", WORDS[pick]);
+    }
+    if (sentence_start && word[0] >= 'a' && word[0] <= 'z') {
+      word[0] = (char) (word[0] - 'a' + 'A');
+    }
+
+    for (size_t i = 0; word[i] != '\0' && index < size; i++) {
+      buffer[index++] = (unsigned char) word[i];
+    }
+
+    sentence_start = (random >> 40) % 12 == 0;
+    if (sentence_start && index < size) {
+      buffer[index++] = '.';
+    } else if ((random >> 48) % 15 == 0 && index < size) {
+      buffer[index++] = ',';
+    }
+
+    line_words += 1;
+    if (index < size) {
+      buffer[index++] = line_words >= 12 ? '\n' : ' ';
+    }
+    if (line_words >= 12) {
+      line_words = 0;
+    }
+  }
+}
+
+/**
+ * Function Name: generateUniform
+ * Purpose: Fills a buffer with encodable characters that are all equally likely
+ * Parameters:
+ *  - unsigned char* buffer: The buffer to fill
+ *  - size_t size: The size of the buffer
+ *  - uint64_t* state: The random generator
+ * Return Value:
+ *  - void
+ */
+void generateUniform(unsigned char* buffer, size_t size, uint64_t* state) {
+  for (size_t i = 0; i < size; i++) {
+    buffer[i] = (unsigned char) ALPHABET[(nextRandom(state) >> 32) % ALPHABET_SIZE];
+  }
+}
+
+/**
+ * Function Name: generateSkewed
+ * Purpose: Fills a buffer with encodable characters of a geometric distribution, the first character of the
+ *  alphabet is half of the text, the second a quarter and so on
+ * Parameters:
+ *  - unsigned char* buffer: The buffer to fill
+ *  - size_t size: The size of the buffer
+ *  - uint64_t* state: The random generator
+ * Return Value:
+ *  - void
+ */
+void generateSkewed(unsigned char* buffer, size_t size, uint64_t* state) {
+  for (size_t i = 0; i < size; i++) {
+    // every trailing zero bit of a random number has a chance of one half
+    uint64_t random = nextRandom(state) | (1ULL << (ALPHABET_SIZE - 1));
+    buffer[i] = (unsigned char) ALPHABET[__builtin_ctzll(random)];
+  }
+}
+
+/**
+ * Function Name: generateRuns
+ * Purpose: Fills a buffer with runs of a random encodable character, each up to MAX_RUN_LENGTH characters long
+ * Parameters:
+ *  - unsigned char* buffer: The buffer to fill
+ *  - size_t size: The size of the buffer
+ *  - uint64_t* state: The random generator
+ * Return Value:
+ *  - void
+ */
+void generateRuns(unsigned char* buffer, size_t size, uint64_t* state) {
+  size_t index = 0;
+  while (index < size) {
+    uint64_t random = nextRandom(state);
+    unsigned char c = (unsigned char) ALPHABET[(random >> 32) % ALPHABET_SIZE];
+    size_t length = 1 + (size_t) (random >> 8) % MAX_RUN_LENGTH;
+    if (length > size - index) {
+      length = size - index;
+    }
+    memset(buffer + index, c, length);
+    index += length;
+  }
+}
+
+// MEASUREMENT
+typedef struct BenchOptions {
+  size_t size;
+  int repetitions;
+  int warmup;
+  int thread_count;
+  uint64_t seed;
+  const char* corpus; // NULL for every corpus
+} BenchOptions;
+
+typedef struct BenchResult {
+  size_t input_size;
+  size_t compressed_size;
+  double entropy; // bits per character of the text the encoder keeps
+  double encode_best; // MB/s of the fastest repetition
+  double encode_mean; // MB/s of the total time of all repetitions
+  double decode_best;
+  double decode_mean;
+  long peak_rss_kb; // of the process that ran the corpus
+} BenchResult;
+
+double getSeconds();
+long peakRssKilobytes(const struct rusage* usage);
+double normalizedEntropy(const unsigned char* input, size_t size, unsigned char* expected, size_t* expected_size);
+int runCorpus(HuffmanEncoder* encoder, HuffmanDecoder* decoder, const Corpus* corpus, const BenchOptions* options, BenchResult* result);
+int runCorpusProcess(const Corpus* corpus, const BenchOptions* options, BenchResult* result);
+void writeResults(FILE* output, const BenchOptions* options, const Corpus* corpora[], const BenchResult results[], int count);
+void printUsage(const char* program);
+
+/**
+ * Function Name: getSeconds
+ * Purpose: Reads the monotonic clock, it is not affected by changes to the time of day
+ * Parameters:
+ *  None
+ * Return Value:
+ *  - double: the time in seconds
+ */
+double getSeconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/**
+ * Function Name: peakRssKilobytes
+ * Purpose: Gets the most memory a process has had resident from its resource usage
+ * Parameters:
+ *  - const struct rusage* usage: The resource usage of the process
+ * Return Value:
+ *  - long: the peak resident set size in KB
+ */
+long peakRssKilobytes(const struct rusage* usage) {
+#ifdef __APPLE__
+  return usage->ru_maxrss / 1024; // bytes on macOS
+#else
+  return usage->ru_maxrss;
+#endif
+}
+
+/**
+ * Function Name: normalizedEntropy
+ * Purpose: Normalizes the input the way the text mode does, into what the decoder should return,
+ *  and computes the order 0 entropy of the result
+ * Parameters:
+ *  - const unsigned char* input: The corpus
+ *  - size_t size: The size of the corpus
+ *  - unsigned char* expected: Room for size bytes, set to the normalized corpus
+ *  - size_t* expected_size: Set to the size of the normalized corpus
+ * Return Value:
+ *  - double: the entropy in bits per character
+ */
+double normalizedEntropy(const unsigned char* input, size_t size, unsigned char* expected, size_t* expected_size) {
+  uint64_t counts[256] = { 0 };
+  size_t index = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    unsigned char c = input[i];
+    if (c >= 'A' && c <= 'Z') {
+      c = (unsigned char) (c - 'A' + 'a');
+    } else if (c == '\t' || c == '\n' || c == '\r') {
+      c = ' ';
+    }
+    if (c != 0 && memchr(ALPHABET, c, ALPHABET_SIZE) != NULL) {
+      expected[index++] = c;
+      counts[c] += 1;
+    }
+  }
+  *expected_size = index;
+
+  double entropy = 0;
+  for (int c = 0; c < 256; c++) {
+    if (counts[c] != 0) {
+      double p = (double) counts[c] / (double) index;
+      entropy -= p * log2(p);
+    }
+  }
+  return entropy;
+}
+
+/**
+ * Function Name: runCorpus
+ * Purpose: Generates a corpus, compresses and decompresses it the amount of warmup runs, and then measures the
+ *  amount of repetitions. Every decoded output is checked against the normalized corpus.
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - HuffmanDecoder* decoder: The decoder
+ *  - const Corpus* corpus: The corpus to run
+ *  - const BenchOptions* options: The size, seed and amount of runs
+ *  - BenchResult* result: Set to the measurements
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+int runCorpus(HuffmanEncoder* encoder, HuffmanDecoder* decoder, const Corpus* corpus, const BenchOptions* options, BenchResult* result) {
+  size_t capacity = huffmanEncodeBound(encoder, options->size);
+  unsigned char* input = (unsigned char*) malloc(options->size);
+  unsigned char* expected = (unsigned char*) malloc(options->size);
+  unsigned char* compressed = (unsigned char*) malloc(capacity);
+  unsigned char* decoded = (unsigned char*) malloc(options->size + 1);
+  int status = 1;
+
+  if (input == NULL || expected == NULL || compressed == NULL || decoded == NULL) {
+    fprintf(stderr, "An error has occured while allocating memory.\n");
+    status = -1;
+  }
+
+  memset(result, 0, sizeof(BenchResult));
+  result->input_size = options->size;
+  size_t expected_size = 0;
+  if (status == 1) {
+    uint64_t state = options->seed == 0 ? DEFAULT_SEED : options->seed;
+    corpus->generate(input, options->size, &state);
+    result->entropy = normalizedEntropy(input, options->size, expected, &expected_size);
+  }
+
+  double megabytes = (double) options->size / (1024.0 * 1024.0);
+  double encode_total = 0;
+  double decode_total = 0;
+  for (int run = 0; status == 1 && run < options->warmup + options->repetitions; run++) {
+    size_t compressed_size = 0;
+    size_t decoded_size = 0;
+
+    double start = getSeconds();
+    if (huffmanEncodeBuffer(encoder, input, options->size, compressed, capacity, &compressed_size) == -1) {
+      status = -1;
+      break;
+    }
+    double middle = getSeconds();
+    if (huffmanDecodeBuffer(decoder, compressed, compressed_size, decoded, options->size + 1, &decoded_size) == -1) {
+      status = -1;
+      break;
+    }
+    double end = getSeconds();
+
+    if (decoded_size != expected_size || memcmp(decoded, expected, expected_size) != 0) {
+      fprintf(stderr, "The decoded %s corpus does not match the input\n", corpus->name);
+      status = -1;
+      break;
+    }
+
+    // warmup runs fault in the buffers and the thread pools, they are not measured
+    if (run < options->warmup) {
+      continue;
+    }
+    result->compressed_size = compressed_size;
+    encode_total += middle - start;
+    decode_total += end - middle;
+    if (megabytes / (middle - start) > result->encode_best) {
+      result->encode_best = megabytes / (middle - start);
+    }
+    if (megabytes / (end - middle) > result->decode_best) {
+      result->decode_best = megabytes / (end - middle);
+    }
+  }
+
+  if (status == 1 && options->repetitions > 0) {
+    result->encode_mean = megabytes * options->repetitions / encode_total;
+    result->decode_mean = megabytes * options->repetitions / decode_total;
+  }
+
+  free(input);
+  free(expected);
+  free(compressed);
+  free(decoded);
+  return status;
+}
+
+/**
+ * Function Name: runCorpusProcess
+ * Purpose: Runs a corpus in a child process with an encoder and decoder of its own, and takes the peak memory of that
+ *  process from wait4. The peak of a process never goes down, so this is what keeps the corpora apart
+ * Parameters:
+ *  - const Corpus* corpus: The corpus to run
+ *  - const BenchOptions* options: The size, seed, threads and amount of runs
+ *  - BenchResult* result: Set to the measurements
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+int runCorpusProcess(const Corpus* corpus, const BenchOptions* options, BenchResult* result) {
+  int pipe_ends[2];
+  if (pipe(pipe_ends) != 0) {
+    perror("pipe");
+    return -1;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t child = fork();
+  if (child == -1) {
+    perror("fork");
+    close(pipe_ends[0]);
+    close(pipe_ends[1]);
+    return -1;
+  }
+
+  // the thread pools are created after the fork, a child only has the thread that forked it
+  if (child == 0) {
+    close(pipe_ends[0]);
+    HuffmanEncoder* encoder = createHuffmanEncoder(0, options->thread_count);
+    HuffmanDecoder* decoder = createHuffmanDecoder(options->thread_count);
+    int status = encoder != NULL && decoder != NULL ? runCorpus(encoder, decoder, corpus, options, result) : -1;
+    if (status == 1 && write(pipe_ends[1], result, sizeof(BenchResult)) != (ssize_t) sizeof(BenchResult)) {
+      status = -1;
+    }
+    freeHuffmanEncoder(encoder);
+    freeHuffmanDecoder(decoder);
+    _exit(status == 1 ? 0 : 1);
+  }
+
+  close(pipe_ends[1]);
+  ssize_t received = read(pipe_ends[0], result, sizeof(BenchResult));
+  close(pipe_ends[0]);
+
+  int child_status;
+  struct rusage usage;
+  if (wait4(child, &child_status, 0, &usage) == -1) {
+    perror("wait4");
+    return -1;
+  }
+  if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0 || received != (ssize_t) sizeof(BenchResult)) {
+    return -1;
+  }
+
+  result->peak_rss_kb = peakRssKilobytes(&usage);
+  return 1;
+}
+
+/**
+ * Function Name: writeResults
+ * Purpose: Writes the options and the result of every corpus as a JSON document
+ * Parameters:
+ *  - FILE* output: Where the JSON is written
+ *  - const BenchOptions* options: The options of the run
+ *  - const Corpus* corpora[]: The corpora that were run
+ *  - const BenchResult results[]: The result of every corpus
+ *  - int count: The amount of corpora
+ * Return Value:
+ *  - void
+ */
+void writeResults(FILE* output, const BenchOptions* options, const Corpus* corpora[], const BenchResult results[], int count) {
+  fprintf(output, "{\n");
+  fprintf(output, "  \"size\": %zu,\n", options->size);
+  fprintf(output, "  \"seed\": %llu,\n", (unsigned long long) options->seed);
+  fprintf(output, "  \"warmup\": %d,\n", options->warmup);
+  fprintf(output, "  \"repetitions\": %d,\n", options->repetitions);
+  fprintf(output, "  \"threads\": %d,\n", options->thread_count);
+  fprintf(output, "  \"corpora\": [\n");
+
+  for (int i = 0; i < count; i++) {
+    const BenchResult* result = &results[i];
+    double ratio = result->compressed_size == 0 ? 0 : (double) result->input_size / (double) result->compressed_size;
+    fprintf(output, "    {\n");
+    fprintf(output, "      \"name\": \"%s\",\n", corpora[i]->name);
+    fprintf(output, "      \"input_bytes\": %zu,\n", result->input_size);
+    fprintf(output, "      \"compressed_bytes\": %zu,\n", result->compressed_size);
+    fprintf(output, "      \"ratio\": %.4f,\n", ratio);
+    fprintf(output, "      \"entropy_bits_per_char\": %.4f,\n", result->entropy);
+    fprintf(output, "      \"encode_mb_s\": { \"best\": %.2f, \"mean\": %.2f },\n", result->encode_best, result->encode_mean);
+    fprintf(output, "      \"decode_mb_s\": { \"best\": %.2f, \"mean\": %.2f },\n", result->decode_best, result->decode_mean);
+    fprintf(output, "      \"peak_rss_kb\": %ld\n", result->peak_rss_kb);
+    fprintf(output, "    }%s\n", i + 1 < count ? "," : "");
+  }
+
+  fprintf(output, "  ]\n");
+  fprintf(output, "}\n");
+}
+
+/**
+ * Function Name: printUsage
+ * Purpose: Prints how to run the program
+ * Parameters:
+ *  - const char* program: The name the program was run with
+ * Return Value:
+ *  - void
+ */
+void printUsage(const char* program) {
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "Compresses and decompresses generated corpora and writes the throughput, ratio and memory use as JSON.\n"
+    "The HUFFMAN_* environment variables configure the encoder and decoder as they do for the programs.\n"
+    "\n"
+    "Options:\n"
+    "  -n bytes  size of every corpus (16 MB by default)\n"
+    "  -r count  measured repetitions (5 by default)\n"
+    "  -w count  warmup runs before the measured ones (1 by default)\n"
+    "  -t count  threads of the encoder and decoder (one per core by default)\n"
+    "  -s seed   seed of the corpus generator (1 by default)\n"
+    "  -c name   run a single corpus: english, uniform, skewed or runs\n"
+    "  -o file   write the JSON to file instead of stdout\n"
+    "  -h        show this message\n",
+    program);
+}
+
+int main(int argc, char* argv[]) {
+  BenchOptions options = { DEFAULT_CORPUS_SIZE, 5, 1, 0, DEFAULT_SEED, NULL };
+  const char* output_name = NULL;
+
+  int option;
+  while ((option = getopt(argc, argv, "n:r:w:t:s:c:o:h")) != -1) {
+    switch (option) {
+      case 'n':
+        options.size = (size_t) strtoull(optarg, NULL, 10);
+        break;
+      case 'r':
+        options.repetitions = atoi(optarg);
+        break;
+      case 'w':
+        options.warmup = atoi(optarg);
+        break;
+      case 't':
+        options.thread_count = atoi(optarg);
+        break;
+      case 's':
+        options.seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'c':
+        options.corpus = optarg;
+        break;
+      case 'o':
+        output_name = optarg;
+        break;
+      case 'h':
+        printUsage(argv[0]);
+        return 0;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (optind != argc || options.size == 0 || options.repetitions < 1 || options.warmup < 0 || options.thread_count < 0) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  const Corpus* corpora[CORPUS_COUNT];
+  int corpus_count = 0;
+  for (size_t i = 0; i < CORPUS_COUNT; i++) {
+    if (options.corpus == NULL || strcmp(options.corpus, CORPORA[i].name) == 0) {
+      corpora[corpus_count++] = &CORPORA[i];
+    }
+  }
+  if (corpus_count == 0) {
+    fprintf(stderr, "Unknown corpus %s\n", options.corpus);
+    return 1;
+  }
+
+  BenchResult results[CORPUS_COUNT];
+  int status = 0;
+  for (int i = 0; i < corpus_count; i++) {
+    if (runCorpusProcess(corpora[i], &options, &results[i]) == -1) {
+      status = 1;
+      break;
+    }
+  }
+
+  if (status != 0) {
+    return status;
+  }
+
+  FILE* output = output_name == NULL ? stdout : fopen(output_name, "w");
+  if (output == NULL) {
+    perror(output_name);
+    return 1;
+  }
+  writeResults(output, &options, corpora, results, corpus_count);
+  if (output != stdout) {
+    fclose(output);
+  }
+
+  return 0;
+}
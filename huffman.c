@@ -0,0 +1,4868 @@
+/**
+ * Description: The huffman codec behind encode.c and decode.c. Everything works on memory buffers or on files,
+ *  the public functions are declared in huffman.h and everything else is internal to this file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__AVX2__) && defined(__BMI2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "huffman.h"
+
+// CONTAINER FORMAT
+// compressed.bin starts with a fixed header:
+//  - 4 bytes magic, 1 byte version, 1 byte mode (HUFFMAN_MODE_TEXT or HUFFMAN_MODE_RAW), 1 byte amount of streams
+//    per block, 1 reserved byte
+// followed by the blocks, every block starts with:
+//  - 1 byte block type
+//  - 4 bytes amount of encoded characters
+//  - 4 bytes size of the bitstream in bytes
+// a block with a new table then has 2 bytes amount of characters that have a code, and a (character, code length)
+// byte pair for every one of them, a block encoded with a dictionary has the 4 bytes id of the dictionary instead.
+// the bitstream of the block follows, padded to a whole byte.
+// with more than one stream the characters of a block are split into that many consecutive runs that are each
+// encoded as a bitstream of their own, padded to a whole byte. 4 bytes size of every stream but the last come
+// before the bitstreams, which follow each other and together make up the size of the bitstream of the block.
+// a single end block type byte closes the blocks. the block index follows, for every block:
+//  - 8 bytes offset of the block in the file, 8 bytes bit length of its bitstream, 8 bytes amount of encoded characters
+// and the file ends with a footer:
+//  - 8 bytes offset of the block index, 4 bytes amount of blocks, 4 bytes footer magic
+// all numbers are little endian
+#define CONTAINER_MAGIC "HUFZ"
+#define CONTAINER_VERSION 3
+#define CONTAINER_HEADER_SIZE 8
+
+#define BLOCK_TYPE_END 0
+#define BLOCK_TYPE_NEW_TABLE 1
+#define BLOCK_TYPE_REUSE_TABLE 2 // the block is encoded with the table of the block before it
+#define BLOCK_TYPE_DICTIONARY 3 // the block is encoded with the table of a dictionary the decoder has to be given
+#define DICTIONARY_ID_BYTES 4
+#define BLOCK_HEADER_SIZE 9
+#define STREAM_SIZE_BYTES 4
+
+// room for the block header, the amount of codes, a pair for every character and the size of every stream
+#define BLOCK_HEADER_MAX_SIZE (BLOCK_HEADER_SIZE + 2 + 256 * 2 + (HUFFMAN_MAX_STREAMS - 1) * STREAM_SIZE_BYTES)
+
+#define BLOCK_INDEX_ENTRY_SIZE 24
+#define CONTAINER_FOOTER_MAGIC "HUFX"
+#define CONTAINER_FOOTER_SIZE 16
+
+// DICTIONARY FORMAT
+// a dictionary is a code length table trained on sample inputs, so small inputs do not need a table of their own.
+// the file starts with a fixed header:
+//  - 4 bytes magic, 1 byte version, 1 byte mode, 2 reserved bytes, 4 bytes dictionary id
+// followed by 2 bytes amount of characters that have a code, and a (character, code length) byte pair for every one
+// of them. every character of the alphabet of the mode has a code, so any input can be encoded with it
+#define DICTIONARY_MAGIC "HUFD"
+#define DICTIONARY_VERSION 1
+#define DICTIONARY_HEADER_SIZE 12
+
+typedef struct BlockIndexEntry {
+  uint64_t offset; // where the block header starts in the file
+  uint64_t bit_length; // length of the bitstream without the padding
+  uint64_t decoded_length; // amount of encoded characters
+} BlockIndexEntry;
+
+// the input is split into blocks of this many bytes before normalization, every block gets its own table.
+// HUFFMAN_BLOCK_SIZE overrides the default within the limits
+#define DEFAULT_BLOCK_SIZE (1024 * 1024)
+#define MIN_BLOCK_SIZE (4 * 1024)
+#define MAX_BLOCK_SIZE (16 * 1024 * 1024)
+
+// codes are never longer than the maximum code length, HUFFMAN_MAX_CODE_LENGTH overrides the default within the limits.
+// the decoder resolves a code of up to 11 + 8 bits with one probe of its primary table and one of a secondary table
+#define DEFAULT_MAX_CODE_LENGTH 15
+#define MIN_MAX_CODE_LENGTH 6
+#define MAX_MAX_CODE_LENGTH 19
+
+// a block is a single bitstream unless HUFFMAN_STREAMS or huffmanSetStreamCount asks for more,
+// the decoder follows the streams of a block side by side so their codes are looked up at the same time
+#define DEFAULT_STREAM_COUNT 1
+
+// with HUFFMAN_TABLE_CACHE or huffmanSetTableCache a block takes the table an earlier input built for a histogram of
+// the same shape, as long as that table costs at most the margin in percent more than the entropy of the block.
+// the encoder keeps this many tables and the decoder keeps as many decode tables, so neither builds them again
+#define TABLE_CACHE_SIZE 8
+#define TABLE_CACHE_OFF -1
+#define MAX_TABLE_CACHE_MARGIN 100
+
+// the relative frequency of every character is quantized to half powers of two for the fingerprint of a histogram,
+// a cached table is tried when no character is more than one level away from the fingerprint it was built for
+#define FINGERPRINT_SCALE_BITS 20
+#define FINGERPRINT_TOLERANCE 1
+
+typedef struct BlockHeader {
+  int block_type;
+  uint64_t symbol_count; // amount of encoded characters
+  size_t payload_offset; // where the bitstream starts in the file
+  uint64_t payload_size; // size of the bitstream in bytes
+  int stream_count;
+  uint64_t stream_sizes[HUFFMAN_MAX_STREAMS]; // size of every stream in bytes, they add up to payload_size
+  uint32_t dictionary_id; // only for blocks encoded with a dictionary
+} BlockHeader;
+
+static uint64_t loadLittleEndian(const unsigned char* input, int byte_count);
+static void storeLittleEndian(unsigned char* output, uint64_t value, int byte_count);
+static uint64_t streamStart(uint64_t symbol_count, int stream_count, int stream);
+
+/**
+ * Function Name: loadLittleEndian
+ * Purpose: Reads a little endian number from the header
+ * Parameters:
+ *  - const unsigned char* input: The first byte of the number
+ *  - int byte_count: The size of the number in bytes
+ * 
+ * Returns:
+ *  - uint64_t: the number
+ */
+static uint64_t loadLittleEndian(const unsigned char* input, int byte_count) {
+  uint64_t value = 0;
+  for (int i = byte_count - 1; i >= 0; i--) {
+    value = (value << 8) | input[i];
+  }
+  return value;
+}
+
+/**
+ * Function Name: storeLittleEndian
+ * Purpose: Writes a number to the header in little endian order
+ * Parameters:
+ *  - unsigned char* output: Where the first byte is written
+ *  - uint64_t value: The number to write
+ *  - int byte_count: The size of the number in bytes
+ * Return Value:
+ *  - void
+ */
+static void storeLittleEndian(unsigned char* output, uint64_t value, int byte_count) {
+  for (int i = 0; i < byte_count; i++) {
+    output[i] = (unsigned char) (value >> (i * 8));
+  }
+}
+
+/**
+ * Function Name: streamStart
+ * Purpose: Gets the first character of a stream, the streams of a block get runs of the same length
+ *  and the first ones get a character more when the block does not split evenly
+ * Parameters:
+ *  - uint64_t symbol_count: The amount of characters in the block
+ *  - int stream_count: The amount of streams in the block
+ *  - int stream: The stream, stream_count gives the end of the last stream
+ * Return Value:
+ *  - uint64_t: the position of the first character of the stream in the block
+ */
+static uint64_t streamStart(uint64_t symbol_count, int stream_count, int stream) {
+  uint64_t run = symbol_count / (uint64_t) stream_count;
+  uint64_t longer = symbol_count % (uint64_t) stream_count;
+  return run * (uint64_t) stream + ((uint64_t) stream < longer ? (uint64_t) stream : longer);
+}
+
+// STATISTICS
+// a stage adds the time since the previous lap to its total. with the statistics off the clock is never read,
+// so a stage costs one predictable branch
+static const char* const STAGE_NAMES[HUFFMAN_STAGE_COUNT] = {
+  "read", "normalize", "histogram", "table", "pack", "parse", "decode", "write", "frequency_file", "codes_file", "total",
+};
+
+static inline uint64_t statsLap(int timed, uint64_t* lap);
+
+/**
+ * Function Name: statsLap
+ * Purpose: Ends the current lap of a timer and starts the next one
+ * Parameters:
+ *  - int timed: 0 if the statistics are off, the clock is not read then
+ *  - uint64_t* lap: When the current lap started, 0 if the timer has not started yet
+ * Return Value:
+ *  - uint64_t: the length of the lap in nanoseconds, 0 when the statistics are off or the timer just started
+ */
+static inline uint64_t statsLap(int timed, uint64_t* lap) {
+  if (!timed) {
+    return 0;
+  }
+
+  uint64_t now = huffmanStatsClock();
+  uint64_t elapsed = *lap == 0 ? 0 : now - *lap;
+  *lap = now;
+  return elapsed;
+}
+
+// HUFFMAN PRIORITY QUEUE STRUCTURE
+typedef struct MinHeapNode {
+  uint64_t freq;
+  char data;
+  struct MinHeapNode *left;
+  struct MinHeapNode *right;
+} MinHeapNode;
+
+typedef struct MinHeap {
+  struct MinHeapNode **array;
+  int capacity;
+  int size;
+} MinHeap;
+
+// a tree of n characters has 2n - 1 nodes, all of them come from the arena of the block the tree is built for.
+// the arena is reset before the next tree is built instead of freeing the nodes one by one
+#define NODE_ARENA_CAPACITY (2 * 256 - 1)
+
+typedef struct NodeArena {
+  MinHeapNode nodes[NODE_ARENA_CAPACITY];
+  MinHeapNode* heap[256]; // the array of the min heap
+  int used;
+} NodeArena;
+
+static void resetNodeArena(NodeArena* arena);
+static MinHeapNode* createMinHeapNode(NodeArena* arena, char data, uint64_t freq);
+static void createMinHeap(MinHeap* min_heap, NodeArena* arena, int capacity);
+static void swapNodes(MinHeapNode** a, MinHeapNode** b);
+static void minHeapify(MinHeap* min_heap, int i);
+static MinHeapNode* extractMin(MinHeap* min_heap);
+static int insertMinHeap(MinHeap* min_heap, MinHeapNode* node);
+
+/**
+ * Function Name: resetNodeArena
+ * Purpose: Releases every node of the arena at once, the trees built from it can no longer be used
+ * Parameters:
+ *  - NodeArena* arena: The arena to reset
+ * 
+ * Returns:
+ *  - void
+ */
+static void resetNodeArena(NodeArena* arena) {
+  arena->used = 0;
+}
+
+/**
+ * Function Name: createMinHeapNode
+ * Purpose: Creates a min heap node in the arena
+ * Parameters:
+ *  - NodeArena* arena: The arena the node is taken from
+ *  - char data: the character
+ *  - uint64_t freq: frequency of the character
+ * 
+ * Returns:
+ *  - MinHeapNode*: a new min heap node
+ */
+static MinHeapNode* createMinHeapNode(NodeArena* arena, char data, uint64_t freq) {
+  MinHeapNode* node = &arena->nodes[arena->used++];
+  node->data = data;
+  node->freq = freq;
+  node->left = NULL;
+  node->right = NULL;
+  return node;
+}
+
+/**
+ * Function Name: createMinHeap
+ * Purpose: Creates an empty min heap on the heap array of the arena
+ * Parameters:
+ *  - MinHeap* min_heap: The min heap to set up
+ *  - NodeArena* arena: The arena whose heap array is used
+ *  - int capacity: The max capacity of the min heap, at most 256
+ * 
+ * Returns:
+ *  - void
+ */
+static void createMinHeap(MinHeap* min_heap, NodeArena* arena, int capacity) {
+  min_heap->size = 0;
+  min_heap->capacity = capacity;
+  min_heap->array = arena->heap;
+}
+
+/**
+ * Function Name: swapNodes
+ * Purpose: Swaps the location of 2 min heap nodes
+ * Parameters:
+ *  - MinHeapNode** a: Pointer to the first min heap node pointer
+ *  - MinHeapNode** b: Pointer to hte second min heap node pointer
+ * 
+ * Returns:
+ *  - void
+ */
+static void swapNodes(MinHeapNode** a, MinHeapNode** b) {
+  MinHeapNode* t = *a;
+  *a = *b;
+  *b = t;
+}
+
+/**
+ * Function Name: minHeapify
+ * Purpose: Min Heapify to maintain heap properties
+ * Parameters:
+ *  - MinHeap* min_heap: The min_heap to operate on
+ *  - int i: The index of the current node
+ * 
+ * Returns:
+ *  - void
+ */
+static void minHeapify(MinHeap* min_heap, int i) {
+  int smallest = i;
+  int left = 2 * i + 1;
+  int right = 2 * i + 2;
+
+  if (left < min_heap->size && min_heap->array[left]->freq < min_heap->array[smallest]->freq)
+    smallest = left;
+
+  if (right < min_heap->size && min_heap->array[right]->freq < min_heap->array[smallest]->freq)
+    smallest = right;
+
+  if (smallest != i) {
+    swapNodes(&min_heap->array[smallest], &min_heap->array[i]);
+    minHeapify(min_heap, smallest);
+  }
+}
+
+/**
+ * Function Name: extractMin
+ * Purpose: Extracts the root min heap node
+ * Parameters:
+ *  - MinHeap* min_heap: The min_heap to operate on
+ * 
+ * Returns:
+ *  - MinHeapNode*: the min heap node that was extracted
+ */
+static MinHeapNode* extractMin(MinHeap* min_heap) {
+  MinHeapNode* temp = min_heap->array[0];
+  min_heap->array[0] = min_heap->array[min_heap->size - 1];
+  min_heap->size--;
+  minHeapify(min_heap, 0);
+  return temp;
+}
+
+/**
+ * Function Name: insertMinHeap
+ * Purpose: inserts min heap node into the min heap
+ * Parameters:
+ *  - MinHeap* min_heap: The min_heap to operate on
+ *  - MinHeapNode* node: the node to be inserted
+ * Returns:
+ *  - int: -1 if the min heap is full and 1 if successful
+ */
+static int insertMinHeap(MinHeap* min_heap, MinHeapNode* node) {
+  if (min_heap->size >= min_heap->capacity) {
+    fprintf(stderr, "Error: MinHeap is full!\n");
+    return -1;
+  }
+
+  min_heap->size++;
+
+  int current_index = min_heap->size - 1;
+  int parent_index = (current_index - 1)/2;
+
+  // while the node that we are currently trying to insert has a smaller frequency compared to parent
+  while (current_index > 0 && node->freq < min_heap->array[parent_index]->freq) {
+    min_heap->array[current_index] = min_heap->array[parent_index];
+    current_index = parent_index;
+    parent_index = (current_index - 1) / 2;
+  }
+  min_heap->array[current_index] = node;
+  return 1;
+}
+
+// HISTOGRAM
+static const char ENCODABLE_CHARACTERS[] = HUFFMAN_ALPHABET;
+#define ENCODABLE_CHARACTER_COUNT (sizeof(ENCODABLE_CHARACTERS) - 1)
+
+// the characters a mode can encode, in byte order. the table builders only visit these instead of all 256 byte values,
+// and since both alphabets are constants the compiler can specialize those loops for the 39 text characters
+typedef struct Alphabet {
+  const unsigned char* characters;
+  int size;
+} Alphabet;
+
+#define BYTE_ROW(high) high, high + 1, high + 2, high + 3, high + 4, high + 5, high + 6, high + 7, \
+  high + 8, high + 9, high + 10, high + 11, high + 12, high + 13, high + 14, high + 15
+static const unsigned char RAW_CHARACTERS[256] = {
+  BYTE_ROW(0x00), BYTE_ROW(0x10), BYTE_ROW(0x20), BYTE_ROW(0x30), BYTE_ROW(0x40), BYTE_ROW(0x50), BYTE_ROW(0x60), BYTE_ROW(0x70),
+  BYTE_ROW(0x80), BYTE_ROW(0x90), BYTE_ROW(0xa0), BYTE_ROW(0xb0), BYTE_ROW(0xc0), BYTE_ROW(0xd0), BYTE_ROW(0xe0), BYTE_ROW(0xf0),
+};
+
+static const Alphabet TEXT_ALPHABET = { (const unsigned char*) ENCODABLE_CHARACTERS, (int) ENCODABLE_CHARACTER_COUNT };
+static const Alphabet RAW_ALPHABET = { RAW_CHARACTERS, 256 };
+
+// runs of the same byte would make every increment wait on the previous one,
+// spreading consecutive bytes over several tables lets the increments overlap.
+#define HISTOGRAM_SUB_TABLES 4
+
+typedef struct Histogram {
+  uint64_t counts[256]; // indexed directly by byte value
+} Histogram;
+
+static void histogramCount(Histogram* histogram, const unsigned char* bytes, size_t size);
+static void histogramMerge(Histogram* destination, const Histogram* source);
+static const Alphabet* modeAlphabet(int mode);
+
+/**
+ * Function Name: histogramCount
+ * Purpose: Adds the occurrences of every byte in bytes to the histogram
+ * Parameters:
+ *  - Histogram* histogram: The histogram to add to
+ *  - const unsigned char* bytes: The bytes to count
+ *  - size_t size: The amount of bytes
+ * 
+ * Returns:
+ *  - void
+ */
+static void histogramCount(Histogram* histogram, const unsigned char* bytes, size_t size) {
+  uint64_t sub_tables[HISTOGRAM_SUB_TABLES][256];
+  memset(sub_tables, 0, sizeof(sub_tables));
+
+  size_t i = 0;
+  // read 8 bytes at a time and spread them over the sub tables
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, bytes + i, sizeof(word));
+
+    sub_tables[0][word & 0xFF]++;
+    sub_tables[1][(word >> 8) & 0xFF]++;
+    sub_tables[2][(word >> 16) & 0xFF]++;
+    sub_tables[3][(word >> 24) & 0xFF]++;
+    sub_tables[0][(word >> 32) & 0xFF]++;
+    sub_tables[1][(word >> 40) & 0xFF]++;
+    sub_tables[2][(word >> 48) & 0xFF]++;
+    sub_tables[3][word >> 56]++;
+  }
+
+  for (; i < size; i++) {
+    sub_tables[0][bytes[i]]++;
+  }
+
+  for (int c = 0; c < 256; c++) {
+    histogram->counts[c] += sub_tables[0][c] + sub_tables[1][c] + sub_tables[2][c] + sub_tables[3][c];
+  }
+}
+
+/**
+ * Function Name: histogramMerge
+ * Purpose: Adds the counts of one histogram to another
+ * Parameters:
+ *  - Histogram* destination: The histogram that is added to
+ *  - const Histogram* source: The histogram to add
+ * 
+ * Returns:
+ *  - void
+ */
+static void histogramMerge(Histogram* destination, const Histogram* source) {
+  for (int c = 0; c < 256; c++) {
+    destination->counts[c] += source->counts[c];
+  }
+}
+
+/**
+ * Function Name: modeAlphabet
+ * Purpose: Gets the characters a mode can encode
+ * Parameters:
+ *  - int mode: HUFFMAN_MODE_TEXT or HUFFMAN_MODE_RAW
+ * 
+ * Returns:
+ *  - const Alphabet*: the alphabet of the mode
+ */
+static const Alphabet* modeAlphabet(int mode) {
+  return mode == HUFFMAN_MODE_RAW ? &RAW_ALPHABET : &TEXT_ALPHABET;
+}
+
+// the buffer is split into chunks of this size, small enough that a chunk stays in the cache while it is counted
+#define HISTOGRAM_CHUNK_SIZE (256 * 1024)
+
+// below this size starting threads costs more than counting
+#define PARALLEL_HISTOGRAM_MIN_SIZE (4 * HISTOGRAM_CHUNK_SIZE)
+
+typedef struct HistogramWorker {
+  Histogram histogram; // private table, merged once the worker is done
+  const unsigned char* bytes;
+  size_t size;
+  atomic_size_t* next_chunk; // shared between all workers
+} HistogramWorker;
+
+static void* histogramWorkerRun(void* argument);
+static void histogramCountParallel(Histogram* histogram, const unsigned char* bytes, size_t size, int thread_count);
+
+
+/**
+ * Function Name: histogramWorkerRun
+ * Purpose: Thread entry point, claims chunks until none are left and counts them in the private table
+ * Parameters:
+ *  - void* argument: The HistogramWorker of this thread
+ * 
+ * Returns:
+ *  - void*: NULL
+ */
+static void* histogramWorkerRun(void* argument) {
+  HistogramWorker* worker = (HistogramWorker*) argument;
+
+  while (1) {
+    size_t chunk = atomic_fetch_add(worker->next_chunk, 1);
+    size_t start = chunk * HISTOGRAM_CHUNK_SIZE;
+    if (start >= worker->size) {
+      break;
+    }
+
+    size_t chunk_size = worker->size - start;
+    if (chunk_size > HISTOGRAM_CHUNK_SIZE) {
+      chunk_size = HISTOGRAM_CHUNK_SIZE;
+    }
+
+    histogramCount(&worker->histogram, worker->bytes + start, chunk_size);
+  }
+
+  return NULL;
+}
+
+/**
+ * Function Name: histogramCountParallel
+ * Purpose: Adds the occurrences of every byte to the histogram using several threads.
+ *  The counts are identical to histogramCount since every chunk is counted exactly once.
+ * Parameters:
+ *  - Histogram* histogram: The histogram to add to
+ *  - const unsigned char* bytes: The bytes to count
+ *  - size_t size: The amount of bytes
+ *  - int thread_count: The amount of threads to use, including the calling thread
+ * 
+ * Returns:
+ *  - void
+ */
+static void histogramCountParallel(Histogram* histogram, const unsigned char* bytes, size_t size, int thread_count) {
+  size_t chunk_count = (size + HISTOGRAM_CHUNK_SIZE - 1) / HISTOGRAM_CHUNK_SIZE;
+  if ((size_t) thread_count > chunk_count) {
+    thread_count = (int) chunk_count;
+  }
+
+  if (thread_count <= 1 || size < PARALLEL_HISTOGRAM_MIN_SIZE) {
+    histogramCount(histogram, bytes, size);
+    return;
+  }
+
+  HistogramWorker* workers = (HistogramWorker*) calloc((size_t) thread_count, sizeof(HistogramWorker));
+  pthread_t* threads = (pthread_t*) malloc((size_t) thread_count * sizeof(pthread_t));
+  if (workers == NULL || threads == NULL) {
+    free(workers);
+    free(threads);
+    histogramCount(histogram, bytes, size);
+    return;
+  }
+
+  atomic_size_t next_chunk;
+  atomic_init(&next_chunk, 0);
+
+  // the calling thread is worker 0, the rest get their own thread
+  int started = 1;
+  for (int i = 0; i < thread_count; i++) {
+    workers[i].bytes = bytes;
+    workers[i].size = size;
+    workers[i].next_chunk = &next_chunk;
+
+    if (i > 0) {
+      if (pthread_create(&threads[i], NULL, histogramWorkerRun, &workers[i]) != 0) {
+        break; // the workers that did start pick up the remaining chunks
+      }
+      started += 1;
+    }
+  }
+
+  histogramWorkerRun(&workers[0]);
+
+  // reduce the private tables into the result
+  for (int i = 0; i < started; i++) {
+    if (i > 0) {
+      pthread_join(threads[i], NULL);
+    }
+    histogramMerge(histogram, &workers[i].histogram);
+  }
+
+  free(workers);
+  free(threads);
+}
+
+// THREAD POOL
+// every worker owns a deque of task indices, it takes tasks from the back of its own deque and,
+// once that is empty, steals from the front of the other deques so no worker sits idle while tasks are left.
+// the calling thread is worker 0, so a pool of 1 thread runs everything on the calling thread
+typedef void (*PoolTask)(void* argument, int index);
+
+typedef struct WorkerDeque {
+  pthread_mutex_t lock;
+  int* tasks;
+  int head; // next task to steal
+  int tail; // one past the next task the owner takes
+} WorkerDeque;
+
+typedef struct ThreadPool {
+  pthread_t* threads;
+  struct PoolWorker* workers;
+  WorkerDeque* deques;
+  int thread_count; // amount of workers and deques
+  int started_count; // workers that are running, including the calling thread
+  size_t deque_capacity;
+  pthread_mutex_t lock;
+  pthread_cond_t start; // signalled when a new generation of tasks is ready
+  pthread_cond_t finished; // signalled when the last worker runs out of tasks
+  uint64_t generation;
+  int running; // workers still working on the current generation
+  int shutdown;
+  PoolTask task;
+  void* argument;
+} ThreadPool;
+
+typedef struct PoolWorker {
+  ThreadPool* pool;
+  int id;
+} PoolWorker;
+
+static int getThreadCount();
+static ThreadPool* createThreadPool(int thread_count, int task_capacity);
+static int threadPoolReserve(ThreadPool* pool, int task_count);
+static int threadPoolTakeTask(ThreadPool* pool, int id, int* index);
+static void* threadPoolWorkerRun(void* argument);
+static void threadPoolRun(ThreadPool* pool, PoolTask task, void* argument, int task_count);
+static void freeThreadPool(ThreadPool* pool);
+
+/**
+ * Function Name: getThreadCount
+ * Purpose: Gets the amount of threads to use, the HUFFMAN_THREADS environment variable overrides the amount of cores
+ * Parameters:
+ *  None
+ * 
+ * Returns:
+ *  - int: the amount of threads, at least 1
+ */
+static int getThreadCount() {
+  const char* threads = getenv("HUFFMAN_THREADS");
+  if (threads != NULL && atoi(threads) > 0) {
+    return atoi(threads);
+  }
+
+#ifdef _SC_NPROCESSORS_ONLN
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores > 0) {
+    return (int) cores;
+  }
+#endif
+
+  return 1;
+}
+
+/**
+ * Function Name: createThreadPool
+ * Purpose: Creates a thread pool and starts its workers, they wait until threadPoolRun gives them tasks
+ * Parameters:
+ *  - int thread_count: The amount of workers, including the calling thread
+ *  - int task_capacity: The most tasks a single threadPoolRun call can be given
+ * 
+ * Returns:
+ *  - ThreadPool*: The thread pool, NULL if it could not be allocated
+ */
+static ThreadPool* createThreadPool(int thread_count, int task_capacity) {
+  ThreadPool* pool = (ThreadPool*) calloc(1, sizeof(ThreadPool));
+  if (pool == NULL) {
+    return NULL;
+  }
+
+  pool->threads = (pthread_t*) calloc((size_t) thread_count, sizeof(pthread_t));
+  pool->deques = (WorkerDeque*) calloc((size_t) thread_count, sizeof(WorkerDeque));
+  pool->workers = (PoolWorker*) calloc((size_t) thread_count, sizeof(PoolWorker));
+  if (pool->threads == NULL || pool->deques == NULL || pool->workers == NULL) {
+    free(pool->threads);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->finished, NULL);
+
+  // threadPoolRun hands every deque an equal share of the tasks
+  size_t deque_capacity = ((size_t) task_capacity + (size_t) thread_count - 1) / (size_t) thread_count;
+  pool->thread_count = thread_count;
+  pool->started_count = 1;
+  pool->deque_capacity = deque_capacity;
+  int allocated = 1;
+  for (int i = 0; i < thread_count; i++) {
+    pthread_mutex_init(&pool->deques[i].lock, NULL);
+    pool->deques[i].tasks = (int*) malloc(deque_capacity * sizeof(int));
+    if (pool->deques[i].tasks == NULL) {
+      allocated = 0;
+    }
+    pool->workers[i].pool = pool;
+    pool->workers[i].id = i;
+  }
+
+  if (!allocated) {
+    freeThreadPool(pool);
+    return NULL;
+  }
+
+  for (int i = 1; i < thread_count; i++) {
+    if (pthread_create(&pool->threads[i], NULL, threadPoolWorkerRun, &pool->workers[i]) != 0) {
+      break; // the deques of the workers that did not start are emptied by stealing
+    }
+    pool->started_count += 1;
+  }
+
+  return pool;
+}
+
+/**
+ * Function Name: threadPoolReserve
+ * Purpose: Makes room in the deques for task_count tasks, the pool must not be running
+ * Parameters:
+ *  - ThreadPool* pool: The thread pool
+ *  - int task_count: The most tasks the next threadPoolRun calls will be given
+ * 
+ * Returns:
+ *  - int: -1 if the deques could not grow and 1 if successful
+ */
+static int threadPoolReserve(ThreadPool* pool, int task_count) {
+  size_t deque_capacity = ((size_t) task_count + (size_t) pool->thread_count - 1) / (size_t) pool->thread_count;
+  if (deque_capacity <= pool->deque_capacity) {
+    return 1;
+  }
+
+  for (int i = 0; i < pool->thread_count; i++) {
+    int* tasks = (int*) realloc(pool->deques[i].tasks, deque_capacity * sizeof(int));
+    if (tasks == NULL) {
+      return -1;
+    }
+    pool->deques[i].tasks = tasks;
+  }
+
+  pool->deque_capacity = deque_capacity;
+  return 1;
+}
+
+/**
+ * Function Name: threadPoolTakeTask
+ * Purpose: Takes the next task of a worker, from the back of its own deque or from the front of another one
+ * Parameters:
+ *  - ThreadPool* pool: The thread pool
+ *  - int id: The worker taking the task
+ *  - int* index: Set to the index of the task
+ * 
+ * Returns:
+ *  - int: 1 if a task was taken and 0 if every deque is empty
+ */
+static int threadPoolTakeTask(ThreadPool* pool, int id, int* index) {
+  WorkerDeque* own = &pool->deques[id];
+  pthread_mutex_lock(&own->lock);
+  if (own->tail > own->head) {
+    *index = own->tasks[--own->tail];
+    pthread_mutex_unlock(&own->lock);
+    return 1;
+  }
+  pthread_mutex_unlock(&own->lock);
+
+  for (int i = 1; i < pool->thread_count; i++) {
+    WorkerDeque* victim = &pool->deques[(id + i) % pool->thread_count];
+    pthread_mutex_lock(&victim->lock);
+    if (victim->tail > victim->head) {
+      *index = victim->tasks[victim->head++];
+      pthread_mutex_unlock(&victim->lock);
+      return 1;
+    }
+    pthread_mutex_unlock(&victim->lock);
+  }
+
+  // tasks never create other tasks, so once every deque is empty there is nothing left to do
+  return 0;
+}
+
+/**
+ * Function Name: threadPoolWorkerRun
+ * Purpose: Thread entry point, runs the tasks of every generation until the pool shuts down
+ * Parameters:
+ *  - void* argument: The PoolWorker of this thread
+ * 
+ * Returns:
+ *  - void*: NULL
+ */
+static void* threadPoolWorkerRun(void* argument) {
+  PoolWorker* worker = (PoolWorker*) argument;
+  ThreadPool* pool = worker->pool;
+  uint64_t generation = 0;
+
+  while (1) {
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->shutdown && pool->generation == generation) {
+      pthread_cond_wait(&pool->start, &pool->lock);
+    }
+    if (pool->shutdown) {
+      pthread_mutex_unlock(&pool->lock);
+      break;
+    }
+    generation = pool->generation;
+    PoolTask task = pool->task;
+    void* task_argument = pool->argument;
+    pthread_mutex_unlock(&pool->lock);
+
+    int index;
+    while (threadPoolTakeTask(pool, worker->id, &index)) {
+      task(task_argument, index);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->running -= 1;
+    if (pool->running == 0) {
+      pthread_cond_signal(&pool->finished);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  return NULL;
+}
+
+/**
+ * Function Name: threadPoolRun
+ * Purpose: Runs task(argument, index) for every index below task_count and returns once all of them are done.
+ *  The indices are handed out to the deques in contiguous ranges, the workers balance them by stealing.
+ * Parameters:
+ *  - ThreadPool* pool: The thread pool
+ *  - PoolTask task: The function to run
+ *  - void* argument: Passed to every call of task
+ *  - int task_count: The amount of tasks, at most the task capacity of the pool or what was reserved
+ * 
+ * Returns:
+ *  - void
+ */
+static void threadPoolRun(ThreadPool* pool, PoolTask task, void* argument, int task_count) {
+  // the workers are all waiting, so the deques can be filled without their locks
+  for (int i = 0; i < pool->thread_count; i++) {
+    WorkerDeque* deque = &pool->deques[i];
+    int first = (int) ((int64_t) task_count * i / pool->thread_count);
+    int last = (int) ((int64_t) task_count * (i + 1) / pool->thread_count);
+    deque->head = 0;
+    deque->tail = 0;
+    // the owner takes from the back, store the range reversed so it runs in input order
+    for (int index = last - 1; index >= first; index--) {
+      deque->tasks[deque->tail++] = index;
+    }
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->task = task;
+  pool->argument = argument;
+  pool->running = pool->started_count - 1;
+  pool->generation += 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  // the calling thread is worker 0
+  int index;
+  while (threadPoolTakeTask(pool, 0, &index)) {
+    task(argument, index);
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->running > 0) {
+    pthread_cond_wait(&pool->finished, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Function Name: freeThreadPool
+ * Purpose: Stops the workers and frees the thread pool
+ * Parameters:
+ *  - ThreadPool* pool: The thread pool, may be NULL
+ * 
+ * Returns:
+ *  - void
+ */
+static void freeThreadPool(ThreadPool* pool) {
+  if (pool == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 1; i < pool->started_count; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  for (int i = 0; i < pool->thread_count; i++) {
+    pthread_mutex_destroy(&pool->deques[i].lock);
+    free(pool->deques[i].tasks);
+  }
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->finished);
+  free(pool->workers);
+  free(pool->deques);
+  free(pool->threads);
+  free(pool);
+}
+
+
+// FILE INPUT AND OUTPUT
+// the encoder maps regular files read-only and normalizes the blocks straight from the mapping, which saves copying
+// every byte into a buffer first. anything that cannot be mapped (pipes, empty files) is read into the block buffers instead.
+// the decoder maps compressed.bin read-only and decodes straight from the mapping, and decoded.txt is created at its final size
+// and mapped so the blocks are decoded straight into the file. files that cannot be mapped are read and written with stdio.
+// a buffer in memory is handled like a mapping that belongs to the caller
+#if defined(__unix__) || defined(__APPLE__)
+#define USE_MMAP 1
+#endif
+
+typedef struct InputFile {
+  FILE* file; // NULL if the file is mapped
+  const unsigned char* mapping;
+  size_t size; // size of the mapping
+  size_t position; // next byte of the mapping to hand out
+  size_t released; // bytes at the start of the mapping that have been handed back to the kernel
+  int mapped; // 1 if mapping is a mapping of the file, 0 if it is a buffer of the caller
+  int error;
+} InputFile;
+
+typedef struct OutputSink {
+  FILE* file; // NULL when writing to a buffer
+  unsigned char* buffer;
+  size_t capacity; // size of the buffer
+  size_t size; // bytes written to the buffer
+  int error; // set once the buffer is full
+} OutputSink;
+
+typedef struct MappedFile {
+  unsigned char* data;
+  size_t size;
+  int mapped; // 1 if data is a mapping of the file, 0 if it was allocated
+} MappedFile;
+
+static int openInputFile(InputFile* input, const char* file_name);
+static void openInputBuffer(InputFile* input, const unsigned char* buffer, size_t size);
+static size_t readInputBlock(InputFile* input, unsigned char* buffer, size_t block_size, const unsigned char** block);
+static void releaseInput(InputFile* input);
+static void closeInputFile(InputFile* input);
+static void writeOutput(OutputSink* sink, const void* data, size_t size);
+static int mapInputFile(const char* file_name, MappedFile* file);
+static int mapOutputFile(const char* file_name, size_t size, MappedFile* file);
+static void closeMappedFile(MappedFile* file);
+static int closeOutputFile(const char* file_name, MappedFile* file);
+
+/**
+ * Function Name: openInputFile
+ * Purpose: Opens the input file, mapping it into memory when possible
+ * Parameters:
+ *  - InputFile* input: Set to the opened file
+ *  - const char* file_name: The name of the file, "-" for stdin
+ * 
+ * Returns:
+ *  - int: -1 if the file could not be opened and 1 if successful
+ */
+static int openInputFile(InputFile* input, const char* file_name) {
+  memset(input, 0, sizeof(InputFile));
+
+  if (strcmp(file_name, "-") == 0) {
+    input->file = stdin;
+    return 1;
+  }
+
+#ifdef USE_MMAP
+  int descriptor = open(file_name, O_RDONLY);
+  if (descriptor == -1) {
+    return -1;
+  }
+
+  struct stat status;
+  if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+    void* mapping = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (mapping != MAP_FAILED) {
+      // the blocks are read front to back, so the kernel can read ahead aggressively
+      madvise(mapping, (size_t) status.st_size, MADV_SEQUENTIAL);
+      close(descriptor);
+      input->mapping = (const unsigned char*) mapping;
+      input->size = (size_t) status.st_size;
+      input->mapped = 1;
+      return 1;
+    }
+  }
+
+  // fall back to buffered reads on the same descriptor
+  input->file = fdopen(descriptor, "r");
+  if (input->file == NULL) {
+    close(descriptor);
+    return -1;
+  }
+#else
+  input->file = fopen(file_name, "r");
+  if (input->file == NULL) {
+    return -1;
+  }
+#endif
+
+  return 1;
+}
+
+/**
+ * Function Name: openInputBuffer
+ * Purpose: Reads the input from a buffer of the caller, the blocks are normalized straight from it
+ * Parameters:
+ *  - InputFile* input: Set to the buffer
+ *  - const unsigned char* buffer: The input bytes, they are not changed
+ *  - size_t size: The amount of bytes in buffer
+ * 
+ * Returns:
+ *  - void
+ */
+static void openInputBuffer(InputFile* input, const unsigned char* buffer, size_t size) {
+  memset(input, 0, sizeof(InputFile));
+  input->mapping = buffer;
+  input->size = size;
+}
+
+/**
+ * Function Name: readInputBlock
+ * Purpose: Gets the next block of the input, either straight from the mapping or read into the buffer
+ * Parameters:
+ *  - InputFile* input: The input file
+ *  - unsigned char* buffer: Buffer of block_size bytes, only used when the file is not mapped
+ *  - size_t block_size: The most bytes to get
+ *  - const unsigned char** block: Set to the first byte of the block
+ * 
+ * Returns:
+ *  - size_t: the amount of bytes in the block, 0 at the end of the file or on an error
+ */
+static size_t readInputBlock(InputFile* input, unsigned char* buffer, size_t block_size, const unsigned char** block) {
+  if (input->file == NULL) {
+    size_t size = input->size - input->position;
+    if (size > block_size) {
+      size = block_size;
+    }
+    *block = input->mapping + input->position;
+    input->position += size;
+    return size;
+  }
+
+  size_t bytes_read = fread(buffer, 1, block_size, input->file);
+  if (bytes_read < block_size && ferror(input->file)) {
+    input->error = 1;
+  }
+  *block = buffer;
+  return bytes_read;
+}
+
+/**
+ * Function Name: releaseInput
+ * Purpose: Hands the pages of the mapping that have been read back to the kernel, so memory use does not grow with the input
+ * Parameters:
+ *  - InputFile* input: The input file
+ * 
+ * Returns:
+ *  - void
+ */
+static void releaseInput(InputFile* input) {
+#ifdef USE_MMAP
+  // the pages of a buffer belong to the caller
+  if (!input->mapped) {
+    return;
+  }
+
+  size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+  size_t end = input->position / page_size * page_size;
+  if (end > input->released) {
+    madvise((void*) (input->mapping + input->released), end - input->released, MADV_DONTNEED);
+    input->released = end;
+  }
+#else
+  (void) input;
+#endif
+}
+
+/**
+ * Function Name: closeInputFile
+ * Purpose: Closes the input file and removes its mapping
+ * Parameters:
+ *  - InputFile* input: The input file
+ * 
+ * Returns:
+ *  - void
+ */
+static void closeInputFile(InputFile* input) {
+  if (input->file != NULL && input->file != stdin) {
+    fclose(input->file);
+  }
+#ifdef USE_MMAP
+  if (input->mapped) {
+    munmap((void*) input->mapping, input->size);
+  }
+#endif
+  memset(input, 0, sizeof(InputFile));
+}
+
+/**
+ * Function Name: writeOutput
+ * Purpose: Appends bytes to the output file or buffer. Write errors of a file are found by checking it once at the end,
+ *  a buffer that is too small sets the error of the sink and is not written past
+ * Parameters:
+ *  - OutputSink* sink: The output
+ *  - const void* data: The bytes to write
+ *  - size_t size: The amount of bytes
+ * 
+ * Returns:
+ *  - void
+ */
+static void writeOutput(OutputSink* sink, const void* data, size_t size) {
+  if (sink->file != NULL) {
+    fwrite(data, 1, size, sink->file);
+    return;
+  }
+
+  if (sink->error || size > sink->capacity - sink->size) {
+    sink->error = 1;
+    return;
+  }
+  memcpy(sink->buffer + sink->size, data, size);
+  sink->size += size;
+}
+
+/**
+ * Function Name: mapInputFile
+ * Purpose: Maps a file into memory read-only, or reads all of it when it cannot be mapped.
+ *  A file that is read gets 8 zero bytes past its end, a mapped file relies on the block index and footer that follow the blocks
+ * Parameters:
+ *  - const char* file_name: The name of the file, "-" for stdin
+ *  - MappedFile* file: Set to the contents of the file
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+static int mapInputFile(const char* file_name, MappedFile* file) {
+  memset(file, 0, sizeof(MappedFile));
+
+  int from_stdin = strcmp(file_name, "-") == 0;
+  FILE* input = from_stdin ? stdin : fopen(file_name, "rb");
+  if (input == NULL) {
+    perror(file_name);
+    return -1;
+  }
+
+#ifdef USE_MMAP
+  struct stat status;
+  if (fstat(fileno(input), &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+    void* mapping = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fileno(input), 0);
+    if (mapping != MAP_FAILED) {
+      if (!from_stdin) {
+        fclose(input);
+      }
+      file->data = (unsigned char*) mapping;
+      file->size = (size_t) status.st_size;
+      file->mapped = 1;
+      return 1;
+    }
+  }
+#endif
+
+  // read in growing chunks, the size of a pipe is not known up front
+  size_t capacity = 1 << 16;
+  file->data = (unsigned char*) malloc(capacity + 8);
+  while (file->data != NULL) {
+    file->size += fread(file->data + file->size, 1, capacity - file->size, input);
+    if (file->size < capacity) {
+      break;
+    }
+
+    capacity *= 2;
+    unsigned char* grown = (unsigned char*) realloc(file->data, capacity + 8);
+    if (grown == NULL) {
+      free(file->data);
+      file->data = NULL;
+    } else {
+      file->data = grown;
+    }
+  }
+
+  if (file->data == NULL || ferror(input)) {
+    fprintf(stderr, "Failed to read %s\n", file_name);
+    free(file->data);
+    file->data = NULL;
+    if (!from_stdin) {
+      fclose(input);
+    }
+    return -1;
+  }
+
+  memset(file->data + file->size, 0, 8);
+  if (!from_stdin) {
+    fclose(input);
+  }
+  return 1;
+}
+
+/**
+ * Function Name: mapOutputFile
+ * Purpose: Creates a file of the given size and maps it, or allocates a buffer that is written when the file is closed
+ * Parameters:
+ *  - const char* file_name: The name of the file, "-" for stdout
+ *  - size_t size: The size of the file
+ *  - MappedFile* file: Set to the contents of the file
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+static int mapOutputFile(const char* file_name, size_t size, MappedFile* file) {
+  memset(file, 0, sizeof(MappedFile));
+  file->size = size;
+
+#ifdef USE_MMAP
+  int descriptor = strcmp(file_name, "-") == 0 ? -1 : open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (descriptor != -1 && size > 0 && ftruncate(descriptor, (off_t) size) == 0) {
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (mapping != MAP_FAILED) {
+      close(descriptor);
+      file->data = (unsigned char*) mapping;
+      file->mapped = 1;
+      return 1;
+    }
+  }
+  if (descriptor != -1) {
+    close(descriptor);
+  }
+#else
+  (void) file_name;
+#endif
+
+  // one extra byte so an empty file still gets an allocation
+  file->data = (unsigned char*) malloc(size + 1);
+  if (file->data == NULL) {
+    fprintf(stderr, "Failed to allocate memory for content\n");
+    return -1;
+  }
+  return 1;
+}
+
+/**
+ * Function Name: closeMappedFile
+ * Purpose: Removes the mapping of a file or frees its contents
+ * Parameters:
+ *  - MappedFile* file: The file
+ * Return Value:
+ *  - void
+ */
+static void closeMappedFile(MappedFile* file) {
+#ifdef USE_MMAP
+  if (file->mapped) {
+    munmap(file->data, file->size);
+    file->data = NULL;
+  }
+#endif
+  free(file->data);
+  memset(file, 0, sizeof(MappedFile));
+}
+
+/**
+ * Function Name: closeOutputFile
+ * Purpose: Removes the mapping of a file, or writes the buffer to the file when it is not mapped
+ * Parameters:
+ *  - const char* file_name: The name of the file, "-" for stdout
+ *  - MappedFile* file: The file
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+static int closeOutputFile(const char* file_name, MappedFile* file) {
+  if (file->mapped) {
+    closeMappedFile(file);
+    return 1;
+  }
+
+  int to_stdout = strcmp(file_name, "-") == 0;
+  FILE* output = to_stdout ? stdout : fopen(file_name, "w");
+  if (output == NULL) {
+    fprintf(stderr, "Failed to open %s for writing\n", file_name);
+    closeMappedFile(file);
+    return -1;
+  }
+
+  size_t written = fwrite(file->data, 1, file->size, output);
+  int result = (written == file->size && fflush(output) == 0) ? 1 : -1;
+  if (!to_stdout) {
+    fclose(output);
+  }
+  closeMappedFile(file);
+
+  if (result == -1) {
+    fprintf(stderr, "Failed to write %s\n", file_name);
+  }
+  return result;
+}
+
+// BIT PACKING
+typedef struct EncoderTable {
+  uint64_t codes[256]; // code word of every character, right aligned
+  uint8_t lengths[256]; // bit length of every code word, 0 if the character has no code
+} EncoderTable;
+
+typedef struct BitWriter {
+  unsigned char* output; // room for the whole bitstream, and 8 more bytes unless another stream follows it
+  size_t output_index;
+  uint64_t bit_buffer; // 64 bit accumulator, the bits are right aligned and the oldest bit is the most significant one
+  int bit_count;
+} BitWriter;
+
+// PARALLEL BLOCK ENCODER
+// the blocks of a batch are analyzed (normalize, histogram, tree) and packed on the thread pool.
+// choosing between a new table and the previous one is done in input order between the two,
+// so the output is the same for any amount of threads
+
+// the shape of a histogram, histograms of about the same shape get about the same codes
+typedef struct TableFingerprint {
+  int mode;
+  int max_code_length;
+  uint8_t levels[256]; // the quantized relative frequency of every character, 0 if it does not occur
+} TableFingerprint;
+
+// a table built for an earlier input, found by the fingerprint of the histogram it was built for
+typedef struct TableCacheEntry {
+  TableFingerprint fingerprint;
+  EncoderTable table;
+  uint64_t last_use; // 0 for an empty entry, the entry used longest ago is replaced first
+} TableCacheEntry;
+
+typedef struct BlockJob {
+  const unsigned char* source; // the bytes of the block in the mapping, or in input when the file is not mapped
+  size_t bytes_read;
+  unsigned char* input; // block_size bytes, the normalized characters
+  const unsigned char* symbols; // the characters that are encoded, input or source itself in the raw mode
+  size_t size; // amount of characters after normalization
+  Histogram histogram;
+  EncoderTable table; // the table the block is packed with
+  TableFingerprint fingerprint; // of the histogram, only when the table cache is on
+  int cache_entry; // the table cache entry the table was taken from, -1 if it was built
+  int block_type; // BLOCK_TYPE_NEW_TABLE, BLOCK_TYPE_REUSE_TABLE or BLOCK_TYPE_DICTIONARY
+  unsigned char header[BLOCK_HEADER_MAX_SIZE];
+  size_t header_size;
+  uint64_t bit_count; // length of the packed bitstreams without the padding
+  uint64_t payload_size;
+  unsigned char* output; // the packed bitstreams
+  size_t output_capacity;
+  uint64_t nanoseconds[HUFFMAN_STAGE_COUNT]; // time of the stages that ran on the thread pool, merged in input order
+  uint64_t allocations;
+  int result;
+} BlockJob;
+
+typedef struct BlockBatch {
+  BlockJob* jobs;
+  int count_threads; // threads for counting a single block, only more than 1 when the batch is a single block
+  int max_code_length;
+  int mode;
+  int stream_count;
+  int timed; // 1 if the statistics are on
+  const EncoderTable* dictionary; // the table every block is encoded with, NULL for a table per block
+  uint32_t dictionary_id;
+  const TableCacheEntry* table_cache; // only read while the batch runs, NULL when the cache is off
+  int table_cache_margin;
+} BlockBatch;
+
+struct HuffmanEncoder {
+  ThreadPool* pool;
+  BlockJob* jobs;
+  int batch_capacity;
+  int thread_count;
+  size_t block_size;
+  int max_code_length;
+  int mode; // HUFFMAN_MODE_TEXT or HUFFMAN_MODE_RAW
+  int stream_count; // streams every block is split into
+  Histogram histogram; // the frequency of every character in the last input
+  int has_dictionary;
+  HuffmanDictionary dictionary;
+  EncoderTable dictionary_table; // the canonical codes of the dictionary
+  int table_cache_margin; // percent, TABLE_CACHE_OFF when the cache is off
+  TableCacheEntry table_cache[TABLE_CACHE_SIZE];
+  TableCacheEntry new_tables[TABLE_CACHE_SIZE]; // the first tables the current input built, cached once it is done
+  int new_table_count;
+  uint64_t table_cache_clock;
+  int stats_enabled;
+  HuffmanStats stats;
+};
+
+// ENCODING LOGIC
+static size_t normalizeBytes(const unsigned char *input, size_t size, unsigned char *output);
+static int buildHuffmanTree(const Histogram* histogram, NodeArena* arena, MinHeapNode** root);
+static void computeCodeLengths(MinHeapNode* root, int depth, uint8_t lengths[]);
+static int sortSymbolsByCount(const Histogram* histogram, const Alphabet* alphabet, unsigned char symbols[]);
+static void computeSortedCodeLengths(uint64_t weights[], int count);
+static void limitCodeLengths(const Histogram* histogram, const Alphabet* alphabet, int max_code_length, uint8_t lengths[]);
+static void assignCanonicalCodes(const uint8_t lengths[], const Alphabet* alphabet, EncoderTable* table);
+static void finishEncoderTable(const Histogram* histogram, const Alphabet* alphabet, int max_code_length, uint8_t lengths[], EncoderTable* table);
+static void buildEncoderTable(const Histogram* histogram, const Alphabet* alphabet, int max_code_length, EncoderTable* table);
+static size_t getBlockSize();
+static int getMaxCodeLength();
+static int getStreamCount();
+static int getTableCacheMargin();
+static void histogramFingerprint(const Histogram* histogram, const Alphabet* alphabet, TableFingerprint* fingerprint);
+static uint32_t log2Fixed(uint64_t value);
+static uint64_t entropyBitCount(const Histogram* histogram, const Alphabet* alphabet);
+static int findCachedTable(const TableCacheEntry cache[], const TableFingerprint* fingerprint, const Alphabet* alphabet, const Histogram* histogram, uint64_t* bit_count);
+static int findTableFingerprint(const TableCacheEntry entries[], int entry_count, const TableFingerprint* fingerprint);
+static void updateTableCache(HuffmanEncoder* encoder);
+static int longestCodeLength(size_t block_size, int alphabet_size, int max_code_length);
+static uint64_t encodedBitCount(const Histogram* histogram, const Alphabet* alphabet, const EncoderTable* table);
+static size_t writeBlockHeader(unsigned char* output, int block_type, uint64_t symbol_count, uint64_t payload_size, const Alphabet* alphabet, const EncoderTable* table);
+static uint64_t symbolBitCount(const unsigned char* symbols, size_t size, const EncoderTable* table);
+static int packSymbols(BitWriter* writer, const unsigned char* symbols, size_t size, const EncoderTable* table);
+static int packStreams(BitWriter writers[], int stream_count, const unsigned char* symbols, size_t size, const EncoderTable* table);
+static void alignBitWriter(BitWriter* writer);
+static void writeBlockIndex(OutputSink* output, const BlockIndexEntry* index, uint64_t block_count, uint64_t index_offset);
+static BlockJob* createBlockJobs(int job_count, size_t block_size);
+static void freeBlockJobs(BlockJob* jobs, int job_count);
+static void analyzeBlockTask(void* argument, int index);
+static void packBlockTask(void* argument, int index);
+static int encodeContainer(HuffmanEncoder* encoder, InputFile* input, OutputSink* output);
+
+/**
+ * Maps every input byte to the byte it is encoded as, 0 means the byte is not encodable.
+ * Upper case letters are folded to lower case and tabs, newlines and carriage returns become spaces.
+ */
+static const unsigned char NORMALIZE_TABLE[256] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x20, 0x00, 0x00, 0x20, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x2e, 0x00,
+  0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+  0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+  0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/**
+ * Function Name: normalizeBytesScalar
+ * Purpose: Table driven normalization of a byte range, used for the tail and when no SIMD is available
+ * Parameters:
+ *  - const unsigned char *input: The bytes to normalize
+ *  - size_t size: The amount of bytes in input
+ *  - unsigned char *output: Where the kept bytes are written, may be the same as input
+ * 
+ * Return Value:
+ *  - size_t: the amount of bytes written to output
+ */
+static size_t normalizeBytesScalar(const unsigned char *input, size_t size, unsigned char *output) {
+  size_t output_size = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    unsigned char c = NORMALIZE_TABLE[input[i]];
+    output[output_size] = c;
+    // only advance when the byte is kept, rejected bytes are overwritten by the next one
+    output_size += (c != 0);
+  }
+
+  return output_size;
+}
+
+#if defined(__AVX2__) && defined(__BMI2__)
+/**
+ * Function Name: normalizeVector
+ * Purpose: Folds case and maps whitespace for 32 bytes at once
+ * Parameters:
+ *  - __m256i v: The raw bytes
+ *  - __m256i *normalized: The normalized bytes
+ * 
+ * Return Value:
+ *  - uint32_t: a bit mask with a bit set for every byte that should be kept
+ */
+static inline uint32_t normalizeVector(__m256i v, __m256i *normalized) {
+  // bytes >= 0x80 compare as negative so they never fall inside any of the ranges below
+  __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+  v = _mm256_add_epi8(v, _mm256_and_si256(upper, _mm256_set1_epi8('a' - 'A')));
+
+  __m256i whitespace = _mm256_or_si256(
+    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+  v = _mm256_or_si256(_mm256_andnot_si256(whitespace, v), _mm256_and_si256(whitespace, _mm256_set1_epi8(' ')));
+
+  __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+  __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), v));
+  __m256i punctuation = _mm256_or_si256(
+    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))),
+    _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+
+  *normalized = v;
+  return (uint32_t) _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(digit, lower), punctuation));
+}
+#elif defined(__SSE2__)
+/**
+ * Function Name: normalizeVector
+ * Purpose: Folds case and maps whitespace for 16 bytes at once
+ * Parameters:
+ *  - __m128i v: The raw bytes
+ *  - __m128i *normalized: The normalized bytes
+ * 
+ * Return Value:
+ *  - uint32_t: a bit mask with a bit set for every byte that should be kept
+ */
+static inline uint32_t normalizeVector(__m128i v, __m128i *normalized) {
+  // bytes >= 0x80 compare as negative so they never fall inside any of the ranges below
+  __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+  v = _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8('a' - 'A')));
+
+  __m128i whitespace = _mm_or_si128(
+    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+    _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+  v = _mm_or_si128(_mm_andnot_si128(whitespace, v), _mm_and_si128(whitespace, _mm_set1_epi8(' ')));
+
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+  __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+  __m128i punctuation = _mm_or_si128(
+    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))),
+    _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+
+  *normalized = v;
+  return (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(digit, lower), punctuation));
+}
+#endif
+
+/**
+ * Function Name: normalizeBytes
+ * Purpose: Fused single pass replacement for lowering, whitespace conversion and the character filter.
+ *  Every byte is case folded, whitespace is mapped to ' ' and bytes outside of the encodable alphabet are removed.
+ * Parameters:
+ *  - const unsigned char *input: The bytes to normalize
+ *  - size_t size: The amount of bytes in input
+ *  - unsigned char *output: Where the kept bytes are written, may be the same as input
+ * 
+ * Return Value:
+ *  - size_t: the amount of bytes written to output
+ */
+static size_t normalizeBytes(const unsigned char *input, size_t size, unsigned char *output) {
+  size_t i = 0;
+  size_t output_size = 0;
+
+#if defined(__AVX2__) && defined(__BMI2__)
+  for (; i + 32 <= size; i += 32) {
+    __m256i normalized;
+    uint32_t keep = normalizeVector(_mm256_loadu_si256((const __m256i*) (input + i)), &normalized);
+
+    // the vector is loaded before anything is stored so writing in place is safe
+    if (keep == 0xFFFFFFFFu) {
+      _mm256_storeu_si256((__m256i*) (output + output_size), normalized);
+      output_size += 32;
+      continue;
+    }
+
+    // compact 8 bytes at a time, pext pulls the kept bytes of each group together
+    uint64_t groups[4];
+    _mm256_storeu_si256((__m256i*) groups, normalized);
+    for (int group = 0; group < 4; group++) {
+      uint32_t group_keep = (keep >> (group * 8)) & 0xFF;
+      uint64_t byte_mask = _pdep_u64(group_keep, 0x0101010101010101ULL) * 0xFF;
+      uint64_t packed = _pext_u64(groups[group], byte_mask);
+      memcpy(output + output_size, &packed, sizeof(packed));
+      output_size += (size_t) __builtin_popcount(group_keep);
+    }
+  }
+#elif defined(__SSE2__)
+  for (; i + 16 <= size; i += 16) {
+    __m128i normalized;
+    uint32_t keep = normalizeVector(_mm_loadu_si128((const __m128i*) (input + i)), &normalized);
+
+    // the vector is loaded before anything is stored so writing in place is safe
+    if (keep == 0xFFFF) {
+      _mm_storeu_si128((__m128i*) (output + output_size), normalized);
+      output_size += 16;
+      continue;
+    }
+
+    unsigned char bytes[16];
+    _mm_storeu_si128((__m128i*) bytes, normalized);
+    while (keep != 0) {
+      output[output_size++] = bytes[__builtin_ctz(keep)];
+      keep &= keep - 1;
+    }
+  }
+#endif
+
+  return output_size + normalizeBytesScalar(input + i, size - i, output + output_size);
+}
+
+/**
+ * Function Name: buildHuffmanTree
+ * Purpose: Builds a huffman tree from the frequency data, the arena is reset first and holds the tree afterwards
+ * Parameters:
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - NodeArena* arena: The arena the nodes and the heap array are taken from
+ *  - MinHeapNode** root: Set to the root node for the min_heap, NULL if no character occurs
+ * 
+ * Return Value:
+ *  - int: -1 if the min heap overflowed and 1 if successful
+ */
+static int buildHuffmanTree(const Histogram* histogram, NodeArena* arena, MinHeapNode** root) {
+  resetNodeArena(arena);
+  *root = NULL;
+
+  // First create the min heap and then build it
+  MinHeap heap;
+  MinHeap* min_heap = &heap;
+  // the characters are inserted in byte order, the encodable alphabet is already in that order
+  createMinHeap(min_heap, arena, 256);
+  for (int c = 0; c < 256; c++) {
+
+    // characters that never occur get no code, they would only make the other codes longer
+    if (histogram->counts[c] == 0) {
+      continue;
+    }
+
+    MinHeapNode* node = createMinHeapNode(arena, (char) c, histogram->counts[c]);
+    if (insertMinHeap(min_heap, node) == -1) {
+      return -1;
+    }
+  }
+
+  // nothing to encode
+  if (min_heap->size == 0) {
+    return 1;
+  }
+
+  MinHeapNode* left; 
+  MinHeapNode* right; 
+  MinHeapNode* top;
+
+  while (min_heap->size != 1) {
+    left = extractMin(min_heap);
+    right = extractMin(min_heap);
+
+    // create a node to act as a "buffer" node
+    top = createMinHeapNode(arena, '$', left->freq + right->freq);
+    top->left = left;
+    top->right = right;
+    if (insertMinHeap(min_heap, top) == -1) {
+      return -1;
+    }
+  }
+
+  *root = extractMin(min_heap);
+  return 1;
+}
+
+/**
+ * Function Name: computeCodeLengths
+ * Purpose: Walks the huffman tree and records the depth of every leaf as the code length of its character
+ * Parameters:
+ *  - MinHeapNode* root: The (sub)tree to walk
+ *  - int depth: The depth of root
+ *  - uint8_t lengths[]: The code length of every character, indexed by byte value
+ * Return Value:
+ *  - void;
+ */
+static void computeCodeLengths(MinHeapNode* root, int depth, uint8_t lengths[]) {
+  if (root->left) {
+    computeCodeLengths(root->left, depth + 1, lengths);
+  }
+
+  if (root->right) {
+    computeCodeLengths(root->right, depth + 1, lengths);
+  }
+
+  if (!(root->left) && !(root->right)) {
+    // a tree with a single character still needs one bit per character
+    lengths[(unsigned char) root->data] = (uint8_t) (depth > 0 ? depth : 1);
+  }
+}
+
+// bits of the frequencies sorted per radix pass, small digits keep the passes cheap for the few characters of a block
+#define SORT_RADIX_BITS 6
+
+/**
+ * Function Name: sortSymbolsByCount
+ * Purpose: Sorts the characters that occur by frequency with a radix sort, one pass per digit of the largest frequency.
+ *  The sort is stable, so characters with equal frequencies stay in character order.
+ * Parameters:
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - const Alphabet* alphabet: The characters that can occur
+ *  - unsigned char symbols[]: Set to the characters that occur, lightest first, room for 256
+ * Return Value:
+ *  - int: the amount of characters that occur
+ */
+static int sortSymbolsByCount(const Histogram* histogram, const Alphabet* alphabet, unsigned char symbols[]) {
+  int symbol_count = 0;
+  uint64_t largest = 0;
+  for (int i = 0; i < alphabet->size; i++) {
+    unsigned char c = alphabet->characters[i];
+    if (histogram->counts[c] != 0) {
+      symbols[symbol_count++] = c;
+      largest |= histogram->counts[c];
+    }
+  }
+
+  unsigned char buffer[256];
+  unsigned char* from = symbols;
+  unsigned char* to = buffer;
+  for (int shift = 0; shift < 64 && (largest >> shift) != 0; shift += SORT_RADIX_BITS) {
+    int offsets[1 << SORT_RADIX_BITS] = { 0 };
+    for (int i = 0; i < symbol_count; i++) {
+      offsets[(histogram->counts[from[i]] >> shift) & ((1 << SORT_RADIX_BITS) - 1)]++;
+    }
+
+    int position = 0;
+    for (int digit = 0; digit < (1 << SORT_RADIX_BITS); digit++) {
+      int digit_count = offsets[digit];
+      offsets[digit] = position;
+      position += digit_count;
+    }
+
+    for (int i = 0; i < symbol_count; i++) {
+      to[offsets[(histogram->counts[from[i]] >> shift) & ((1 << SORT_RADIX_BITS) - 1)]++] = from[i];
+    }
+
+    unsigned char* temp = from;
+    from = to;
+    to = temp;
+  }
+
+  if (from != symbols) {
+    memcpy(symbols, from, (size_t) symbol_count);
+  }
+  return symbol_count;
+}
+
+/**
+ * Function Name: computeSortedCodeLengths
+ * Purpose: Computes huffman code lengths in place from frequencies sorted lightest first (Moffat and Katajainen).
+ *  The first pass combines the two lightest items like the huffman tree does, but stores every combined item in the
+ *  slot of an item that was used up, pointing to its parent. The second pass turns the parents into depths and the
+ *  third one hands the depths of the leaves out, so no tree nodes are needed.
+ * Parameters:
+ *  - uint64_t weights[]: The sorted frequencies, replaced by the code length of every one of them
+ *  - int count: The amount of frequencies, at least 2
+ * Return Value:
+ *  - void
+ */
+static void computeSortedCodeLengths(uint64_t weights[], int count) {
+  // combine the items, root is the lightest combined item that is not used yet and leaf the lightest leaf
+  int root = 0;
+  int leaf = 2;
+  weights[0] += weights[1];
+  for (int next = 1; next < count - 1; next++) {
+    if (leaf >= count || weights[root] < weights[leaf]) {
+      weights[next] = weights[root];
+      weights[root++] = (uint64_t) next;
+    } else {
+      weights[next] = weights[leaf++];
+    }
+
+    if (leaf >= count || (root < next && weights[root] < weights[leaf])) {
+      weights[next] += weights[root];
+      weights[root++] = (uint64_t) next;
+    } else {
+      weights[next] += weights[leaf++];
+    }
+  }
+
+  // the combined items now hold the index of their parent, the depth of a parent is known before its children
+  weights[count - 2] = 0;
+  for (int next = count - 3; next >= 0; next--) {
+    weights[next] = weights[weights[next]] + 1;
+  }
+
+  // every level has twice as many slots as the level above has combined items, the rest of them are leaves
+  int available = 1;
+  int used = 0;
+  uint64_t depth = 0;
+  root = count - 2;
+  int next = count - 1;
+  while (available > 0) {
+    while (root >= 0 && weights[root] == depth) {
+      used += 1;
+      root -= 1;
+    }
+    while (available > used) {
+      weights[next--] = depth;
+      available -= 1;
+    }
+    available = 2 * used;
+    depth += 1;
+    used = 0;
+  }
+}
+
+/**
+ * Function Name: limitCodeLengths
+ * Purpose: Finds the optimal code lengths that are no longer than max_code_length with the package-merge algorithm.
+ *  The deepest list holds the characters sorted by frequency, every list above it holds the same characters merged
+ *  with packages of two neighbouring items of the list below. The 2n - 2 lightest items of the top list are chosen,
+ *  and every character gets one bit of code length for every list it is chosen in, on its own or inside a package.
+ * Parameters:
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - const Alphabet* alphabet: The characters that can occur
+ *  - int max_code_length: The longest code allowed, raised when it can not give every character a code
+ *  - uint8_t lengths[]: Set to the code length of every character, 0 if the character has no code
+ * Return Value:
+ *  - void;
+ */
+static void limitCodeLengths(const Histogram* histogram, const Alphabet* alphabet, int max_code_length, uint8_t lengths[]) {
+  unsigned char symbols[256];
+  int symbol_count = sortSymbolsByCount(histogram, alphabet, symbols);
+
+  memset(lengths, 0, 256);
+  if (symbol_count < 2) {
+    if (symbol_count == 1) {
+      lengths[symbols[0]] = 1;
+    }
+    return;
+  }
+
+  while ((1 << max_code_length) < symbol_count) {
+    max_code_length += 1;
+  }
+
+  // a list holds fewer than twice as many items as there are characters. Only whether an item is a package is kept
+  // for every list, the characters chosen from a list are always its lightest ones, and the weights are only
+  // needed for the list below the one being merged
+  uint64_t weights[2][2 * 256];
+  unsigned char is_package[MAX_MAX_CODE_LENGTH][2 * 256];
+  int list_sizes[MAX_MAX_CODE_LENGTH];
+
+  int deepest = max_code_length - 1;
+  for (int i = 0; i < symbol_count; i++) {
+    weights[deepest & 1][i] = histogram->counts[symbols[i]];
+    is_package[deepest][i] = 0;
+  }
+  list_sizes[deepest] = symbol_count;
+
+  for (int level = deepest - 1; level >= 0; level--) {
+    const uint64_t* below = weights[(level + 1) & 1];
+    uint64_t* list = weights[level & 1];
+    int package_count = list_sizes[level + 1] / 2;
+    int leaf = 0;
+    int package = 0;
+    int size = 0;
+
+    // merge the characters with the packages, a character goes first when the weights are equal
+    while (leaf < symbol_count || package < package_count) {
+      uint64_t leaf_weight = leaf < symbol_count ? histogram->counts[symbols[leaf]] : UINT64_MAX;
+      uint64_t package_weight = package < package_count ? below[2 * package] + below[2 * package + 1] : UINT64_MAX;
+      if (leaf < symbol_count && leaf_weight <= package_weight) {
+        list[size] = leaf_weight;
+        is_package[level][size++] = 0;
+        leaf += 1;
+      } else {
+        list[size] = package_weight;
+        is_package[level][size++] = 1;
+        package += 1;
+      }
+    }
+    list_sizes[level] = size;
+  }
+
+  // the packages chosen in a list are made of the first items of the list below it
+  int chosen = 2 * symbol_count - 2;
+  for (int level = 0; level <= deepest && chosen > 0; level++) {
+    int leaf_count = 0;
+    for (int i = 0; i < chosen; i++) {
+      leaf_count += !is_package[level][i];
+    }
+    for (int i = 0; i < leaf_count; i++) {
+      lengths[symbols[i]] += 1;
+    }
+    chosen = 2 * (chosen - leaf_count);
+  }
+}
+
+/**
+ * Function Name: assignCanonicalCodes
+ * Purpose: Assigns canonical huffman codes from the code lengths alone.
+ *  Shorter codes come first and codes of the same length are handed out in character order,
+ *  so the lengths are all the decoder needs to rebuild the exact same codes.
+ * Parameters:
+ *  - const uint8_t lengths[]: The code length of every character, 0 if the character has no code
+ *  - const Alphabet* alphabet: The characters that can have a code
+ *  - EncoderTable* table: The table to fill in
+ * Return Value:
+ *  - void;
+ */
+static void assignCanonicalCodes(const uint8_t lengths[], const Alphabet* alphabet, EncoderTable* table) {
+  uint64_t length_counts[65] = { 0 };
+  for (int i = 0; i < alphabet->size; i++) {
+    length_counts[lengths[alphabet->characters[i]]]++;
+  }
+  length_counts[0] = 0;
+
+  // the first code of every length follows the last code of the length before it
+  uint64_t next_code[65] = { 0 };
+  uint64_t code = 0;
+  for (int length = 1; length <= 64; length++) {
+    code = (code + length_counts[length - 1]) << 1;
+    next_code[length] = code;
+  }
+
+  // the table may hold the codes of another alphabet from an earlier block
+  memset(table->lengths, 0, sizeof(table->lengths));
+  memset(table->codes, 0, sizeof(table->codes));
+  for (int i = 0; i < alphabet->size; i++) {
+    unsigned char c = alphabet->characters[i];
+    table->lengths[c] = lengths[c];
+    table->codes[c] = lengths[c] ? next_code[lengths[c]]++ : 0;
+  }
+}
+
+/**
+ * Function Name: finishEncoderTable
+ * Purpose: Turns huffman code lengths into canonical codes, the lengths are limited with package-merge when they are too long
+ * Parameters:
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - const Alphabet* alphabet: The characters that can occur
+ *  - int max_code_length: The longest code allowed
+ *  - uint8_t lengths[]: The huffman code length of every character, replaced when a code is too long
+ *  - EncoderTable* table: The table to fill in, characters that do not occur get no code
+ * Return Value:
+ *  - void
+ */
+static void finishEncoderTable(const Histogram* histogram, const Alphabet* alphabet, int max_code_length, uint8_t lengths[], EncoderTable* table) {
+  // the huffman lengths are optimal when they fit, package-merge is only needed for deep trees
+  int longest = 0;
+  for (int i = 0; i < alphabet->size; i++) {
+    if (lengths[alphabet->characters[i]] > longest) {
+      longest = lengths[alphabet->characters[i]];
+    }
+  }
+  if (longest > max_code_length) {
+    limitCodeLengths(histogram, alphabet, max_code_length, lengths);
+  }
+
+  assignCanonicalCodes(lengths, alphabet, table);
+}
+
+/**
+ * Function Name: buildEncoderTable
+ * Purpose: Builds the canonical codes of a block from its frequency data. The code lengths are computed from the sorted
+ *  frequencies without building a tree, they cost the same amount of bits as the lengths of the huffman tree.
+ * Parameters:
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - const Alphabet* alphabet: The characters that can occur
+ *  - int max_code_length: The longest code allowed
+ *  - EncoderTable* table: The table to fill in, characters that do not occur get no code
+ * Return Value:
+ *  - void
+ */
+static void buildEncoderTable(const Histogram* histogram, const Alphabet* alphabet, int max_code_length, EncoderTable* table) {
+  unsigned char symbols[256];
+  int symbol_count = sortSymbolsByCount(histogram, alphabet, symbols);
+
+  uint8_t lengths[256] = { 0 };
+  if (symbol_count == 1) {
+    // a single character still needs one bit per character
+    lengths[symbols[0]] = 1;
+  } else if (symbol_count > 1) {
+    uint64_t weights[256];
+    for (int i = 0; i < symbol_count; i++) {
+      weights[i] = histogram->counts[symbols[i]];
+    }
+    computeSortedCodeLengths(weights, symbol_count);
+    for (int i = 0; i < symbol_count; i++) {
+      lengths[symbols[i]] = (uint8_t) weights[i];
+    }
+  }
+
+  finishEncoderTable(histogram, alphabet, max_code_length, lengths, table);
+}
+
+/**
+ * Function Name: getBlockSize
+ * Purpose: Gets the amount of input bytes in a block, HUFFMAN_BLOCK_SIZE overrides the default
+ * Parameters:
+ *  None
+ * Return Value:
+ *  - size_t: the block size, between MIN_BLOCK_SIZE and MAX_BLOCK_SIZE
+ */
+static size_t getBlockSize() {
+  const char* value = getenv("HUFFMAN_BLOCK_SIZE");
+  if (value == NULL || *value == '\0') {
+    return DEFAULT_BLOCK_SIZE;
+  }
+
+  long long block_size = atoll(value);
+  if (block_size < MIN_BLOCK_SIZE) {
+    return MIN_BLOCK_SIZE;
+  }
+  if (block_size > MAX_BLOCK_SIZE) {
+    return MAX_BLOCK_SIZE;
+  }
+  return (size_t) block_size;
+}
+
+/**
+ * Function Name: getMaxCodeLength
+ * Purpose: Gets the longest code the encoder may give a character, HUFFMAN_MAX_CODE_LENGTH overrides the default
+ * Parameters:
+ *  None
+ * Return Value:
+ *  - int: the maximum code length in bits, between MIN_MAX_CODE_LENGTH and MAX_MAX_CODE_LENGTH
+ */
+static int getMaxCodeLength() {
+  const char* value = getenv("HUFFMAN_MAX_CODE_LENGTH");
+  if (value == NULL || *value == '\0') {
+    return DEFAULT_MAX_CODE_LENGTH;
+  }
+
+  int max_code_length = atoi(value);
+  if (max_code_length < MIN_MAX_CODE_LENGTH) {
+    return MIN_MAX_CODE_LENGTH;
+  }
+  if (max_code_length > MAX_MAX_CODE_LENGTH) {
+    return MAX_MAX_CODE_LENGTH;
+  }
+  return max_code_length;
+}
+
+/**
+ * Function Name: getStreamCount
+ * Purpose: Gets the amount of streams every block is split into, HUFFMAN_STREAMS overrides the default
+ * Parameters:
+ *  None
+ * Return Value:
+ *  - int: the amount of streams, between 1 and HUFFMAN_MAX_STREAMS
+ */
+static int getStreamCount() {
+  const char* value = getenv("HUFFMAN_STREAMS");
+  if (value == NULL || *value == '\0') {
+    return DEFAULT_STREAM_COUNT;
+  }
+
+  int stream_count = atoi(value);
+  if (stream_count < 1) {
+    return 1;
+  }
+  if (stream_count > HUFFMAN_MAX_STREAMS) {
+    return HUFFMAN_MAX_STREAMS;
+  }
+  return stream_count;
+}
+
+/**
+ * Function Name: getTableCacheMargin
+ * Purpose: Gets the margin of the table cache, HUFFMAN_TABLE_CACHE turns the cache on
+ * Parameters:
+ *  None
+ * Return Value:
+ *  - int: the margin in percent up to MAX_TABLE_CACHE_MARGIN, TABLE_CACHE_OFF if the cache is off
+ */
+static int getTableCacheMargin() {
+  const char* value = getenv("HUFFMAN_TABLE_CACHE");
+  if (value == NULL || *value == '\0') {
+    return TABLE_CACHE_OFF;
+  }
+
+  int margin = atoi(value);
+  if (margin < 0) {
+    return TABLE_CACHE_OFF;
+  }
+  if (margin > MAX_TABLE_CACHE_MARGIN) {
+    return MAX_TABLE_CACHE_MARGIN;
+  }
+  return margin;
+}
+
+/**
+ * Function Name: histogramFingerprint
+ * Purpose: Quantizes the shape of a histogram. The relative frequency of every character is rounded down to a half
+ *  power of two, which is close to the code length it gets
+ * Parameters:
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - const Alphabet* alphabet: The characters that can occur
+ *  - TableFingerprint* fingerprint: Set to the levels of the characters, its mode and maximum code length are set by the caller
+ * Return Value:
+ *  - void
+ */
+static void histogramFingerprint(const Histogram* histogram, const Alphabet* alphabet, TableFingerprint* fingerprint) {
+  uint64_t total = 0;
+  for (int i = 0; i < alphabet->size; i++) {
+    total += histogram->counts[alphabet->characters[i]];
+  }
+
+  memset(fingerprint->levels, 0, sizeof(fingerprint->levels));
+  for (int i = 0; i < alphabet->size; i++) {
+    unsigned char c = alphabet->characters[i];
+    uint64_t count = histogram->counts[c];
+    if (count == 0) {
+      continue;
+    }
+
+    // two levels per power of two, from the highest two bits of the scaled frequency
+    uint64_t scaled = (count << FINGERPRINT_SCALE_BITS) / total;
+    int bits = scaled == 0 ? 0 : 64 - __builtin_clzll(scaled);
+    fingerprint->levels[c] = (uint8_t) (1 + bits * 2 + (bits >= 2 ? (scaled >> (bits - 2)) & 1 : 0));
+  }
+}
+
+/**
+ * Function Name: log2Fixed
+ * Purpose: Computes the base 2 logarithm of an integer with 10 fractional bits, by squaring the mantissa
+ *  once for every fractional bit, so the library does not need the math library
+ * Parameters:
+ *  - uint64_t value: The number, at least 1
+ * Return Value:
+ *  - uint32_t: log2(value) * 1024, rounded down
+ */
+static uint32_t log2Fixed(uint64_t value) {
+  int integer = 63 - __builtin_clzll(value);
+
+  // the mantissa in [1, 2) with 30 fractional bits
+  uint64_t mantissa = integer >= 30 ? value >> (integer - 30) : value << (30 - integer);
+  uint32_t result = (uint32_t) integer << 10;
+  for (int bit = 9; bit >= 0; bit--) {
+    mantissa = (mantissa * mantissa) >> 30;
+    if (mantissa >= (2ull << 30)) {
+      mantissa >>= 1;
+      result |= 1u << bit;
+    }
+  }
+  return result;
+}
+
+/**
+ * Function Name: entropyBitCount
+ * Purpose: Estimates the amount of bits the best possible table would need for the characters of a histogram.
+ *  No table needs fewer bits than the entropy, the best one usually needs a few percent more
+ * Parameters:
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - const Alphabet* alphabet: The characters that can occur
+ * Return Value:
+ *  - uint64_t: the entropy of the histogram times its amount of characters, in bits
+ */
+static uint64_t entropyBitCount(const Histogram* histogram, const Alphabet* alphabet) {
+  uint64_t total = 0;
+  for (int i = 0; i < alphabet->size; i++) {
+    total += histogram->counts[alphabet->characters[i]];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  uint32_t total_log = log2Fixed(total);
+  uint64_t bits = 0;
+  for (int i = 0; i < alphabet->size; i++) {
+    uint64_t count = histogram->counts[alphabet->characters[i]];
+    if (count != 0) {
+      bits += count * (total_log - log2Fixed(count));
+    }
+  }
+  return bits >> 10;
+}
+
+/**
+ * Function Name: findCachedTable
+ * Purpose: Finds the cheapest cached table for a histogram among the tables built for a histogram of about the same
+ *  shape, only reads the cache
+ * Parameters:
+ *  - const TableCacheEntry cache[]: The TABLE_CACHE_SIZE entries of the cache
+ *  - const TableFingerprint* fingerprint: The fingerprint of the histogram
+ *  - const Alphabet* alphabet: The characters that can occur
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - uint64_t* bit_count: Set to the amount of bits the characters take with the table that was found
+ * Return Value:
+ *  - int: the entry, -1 if no table is close enough or none has a code for every character that occurs
+ */
+static int findCachedTable(const TableCacheEntry cache[], const TableFingerprint* fingerprint, const Alphabet* alphabet, const Histogram* histogram, uint64_t* bit_count) {
+  int best = -1;
+  *bit_count = UINT64_MAX;
+  for (int i = 0; i < TABLE_CACHE_SIZE; i++) {
+    const TableFingerprint* cached = &cache[i].fingerprint;
+    if (cache[i].last_use == 0 || cached->mode != fingerprint->mode || cached->max_code_length != fingerprint->max_code_length) {
+      continue;
+    }
+
+    int close = 1;
+    for (int j = 0; j < alphabet->size && close; j++) {
+      unsigned char c = alphabet->characters[j];
+      close = abs((int) cached->levels[c] - (int) fingerprint->levels[c]) <= FINGERPRINT_TOLERANCE;
+    }
+    if (!close) {
+      continue;
+    }
+
+    uint64_t entry_bit_count = encodedBitCount(histogram, alphabet, &cache[i].table);
+    if (entry_bit_count < *bit_count) {
+      *bit_count = entry_bit_count;
+      best = i;
+    }
+  }
+  return best;
+}
+
+/**
+ * Function Name: findTableFingerprint
+ * Purpose: Finds the entry with exactly the same fingerprint, so a histogram shape is only cached once
+ * Parameters:
+ *  - const TableCacheEntry entries[]: The entries to search
+ *  - int entry_count: The amount of entries
+ *  - const TableFingerprint* fingerprint: The fingerprint
+ * Return Value:
+ *  - int: the entry, -1 if none has the fingerprint
+ */
+static int findTableFingerprint(const TableCacheEntry entries[], int entry_count, const TableFingerprint* fingerprint) {
+  for (int i = 0; i < entry_count; i++) {
+    if (entries[i].last_use != 0 && memcmp(&entries[i].fingerprint, fingerprint, sizeof(TableFingerprint)) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Function Name: updateTableCache
+ * Purpose: Moves the tables the last input built into the table cache, replacing the table of the same fingerprint,
+ *  an empty entry or the entry used longest ago. Doing this once the input is done keeps the cache the same for every
+ *  block of an input, so the output does not depend on how many blocks a batch holds
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ * Return Value:
+ *  - void
+ */
+static void updateTableCache(HuffmanEncoder* encoder) {
+  for (int i = 0; i < encoder->new_table_count; i++) {
+    int entry = findTableFingerprint(encoder->table_cache, TABLE_CACHE_SIZE, &encoder->new_tables[i].fingerprint);
+    if (entry == -1) {
+      entry = 0;
+      for (int j = 1; j < TABLE_CACHE_SIZE; j++) {
+        if (encoder->table_cache[j].last_use < encoder->table_cache[entry].last_use) {
+          entry = j;
+        }
+      }
+    }
+
+    encoder->table_cache[entry] = encoder->new_tables[i];
+    encoder->table_cache[entry].last_use = ++encoder->table_cache_clock;
+  }
+  encoder->new_table_count = 0;
+}
+
+/**
+ * Function Name: longestCodeLength
+ * Purpose: Gets the longest code a block can get. A huffman code of length L needs a total frequency of at least
+ *  the (L + 2)th fibonacci number, there are never more codes than characters in the alphabet, and codes are never
+ *  longer than the maximum code length unless that is too short for the whole alphabet.
+ * Parameters:
+ *  - size_t block_size: The amount of input bytes in a block
+ *  - int alphabet_size: The amount of characters that can be encoded
+ *  - int max_code_length: The maximum code length of the encoder
+ * Return Value:
+ *  - int: the longest code length in bits
+ */
+static int longestCodeLength(size_t block_size, int alphabet_size, int max_code_length) {
+  while ((1 << max_code_length) < alphabet_size) {
+    max_code_length += 1;
+  }
+
+  uint64_t previous = 1;
+  uint64_t current = 1;
+  int length = 0;
+  while (length < alphabet_size - 1 && previous + current <= block_size) {
+    uint64_t next = previous + current;
+    previous = current;
+    current = next;
+    length += 1;
+  }
+
+  if (length > max_code_length) {
+    length = max_code_length;
+  }
+
+  // a block with a single character still needs one bit per character
+  return length > 0 ? length : 1;
+}
+
+/**
+ * Function Name: encodedBitCount
+ * Purpose: Counts the bits the characters of a histogram take when they are encoded with a table
+ * Parameters:
+ *  - const Histogram* histogram: histogram with frequency data
+ *  - const Alphabet* alphabet: The characters that can occur
+ *  - const EncoderTable* table: The codes
+ * Return Value:
+ *  - uint64_t: the amount of bits, UINT64_MAX if a character that occurs has no code
+ */
+static uint64_t encodedBitCount(const Histogram* histogram, const Alphabet* alphabet, const EncoderTable* table) {
+  uint64_t bit_count = 0;
+  for (int i = 0; i < alphabet->size; i++) {
+    unsigned char c = alphabet->characters[i];
+    if (histogram->counts[c] == 0) {
+      continue;
+    }
+    if (table->lengths[c] == 0) {
+      return UINT64_MAX;
+    }
+    bit_count += histogram->counts[c] * table->lengths[c];
+  }
+  return bit_count;
+}
+
+/**
+ * Function Name: writeBlockHeader
+ * Purpose: Writes the header of a block, with the code length table if the block has a new one.
+ *  The id of a dictionary is written by the caller
+ * Parameters:
+ *  - unsigned char* output: Where the header is written, room for BLOCK_HEADER_MAX_SIZE bytes
+ *  - int block_type: BLOCK_TYPE_NEW_TABLE, BLOCK_TYPE_REUSE_TABLE or BLOCK_TYPE_DICTIONARY
+ *  - uint64_t symbol_count: The amount of characters in the block
+ *  - uint64_t payload_size: The size of the bitstream of the block in bytes
+ *  - const Alphabet* alphabet: The characters that can have a code
+ *  - const EncoderTable* table: The codes, only their lengths are written
+ * Return Value:
+ *  - size_t: the size of the header in bytes
+ */
+static size_t writeBlockHeader(unsigned char* output, int block_type, uint64_t symbol_count, uint64_t payload_size, const Alphabet* alphabet, const EncoderTable* table) {
+  output[0] = (unsigned char) block_type;
+  storeLittleEndian(output + 1, symbol_count, 4);
+  storeLittleEndian(output + 5, payload_size, 4);
+
+  if (block_type != BLOCK_TYPE_NEW_TABLE) {
+    return BLOCK_HEADER_SIZE;
+  }
+
+  size_t size = BLOCK_HEADER_SIZE + 2;
+  int code_count = 0;
+  for (int i = 0; i < alphabet->size; i++) {
+    unsigned char c = alphabet->characters[i];
+    if (table->lengths[c] != 0) {
+      output[size++] = c;
+      output[size++] = table->lengths[c];
+      code_count += 1;
+    }
+  }
+  storeLittleEndian(output + BLOCK_HEADER_SIZE, (uint64_t) code_count, 2);
+
+  return size;
+}
+
+/**
+ * Function Name: storeBigEndian64
+ * Purpose: Stores a 64 bit word so the most significant bit ends up first in the file
+ * Parameters:
+ *  - unsigned char* output: Where the 8 bytes are written
+ *  - uint64_t word: The word to store
+ * Return Value:
+ *  - void
+ */
+static inline void storeBigEndian64(unsigned char* output, uint64_t word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  memcpy(output, &word, sizeof(word));
+}
+
+/**
+ * Function Name: symbolBitCount
+ * Purpose: Counts the bits a run of characters takes when it is encoded with a table
+ * Parameters:
+ *  - const unsigned char* symbols: The characters
+ *  - size_t size: The amount of characters
+ *  - const EncoderTable* table: The codes
+ * Return Value:
+ *  - uint64_t: the amount of bits
+ */
+static uint64_t symbolBitCount(const unsigned char* symbols, size_t size, const EncoderTable* table) {
+  uint64_t bit_count = 0;
+  for (size_t i = 0; i < size; i++) {
+    bit_count += table->lengths[symbols[i]];
+  }
+  return bit_count;
+}
+
+/**
+ * Function Name: appendCode
+ * Purpose: Appends the code of a character to a bit writer, packStreams uses it for the writer of every stream
+ * Parameters:
+ *  - BitWriter* writer: The writer to append to
+ *  - const EncoderTable* table: The code word and bit length of every character
+ *  - unsigned char symbol: The character to encode
+ * Return Value:
+ *  - int: -1 if the character has no code and 1 if successful
+ */
+static inline int appendCode(BitWriter* writer, const EncoderTable* table, unsigned char symbol) {
+  uint64_t code = table->codes[symbol];
+  int length = table->lengths[symbol];
+
+  if (length == 0) {
+    fprintf(stderr, "Error: Code not found for key '%c'\n", symbol);
+    return -1;
+  }
+
+  if (writer->bit_count + length < 64) {
+    writer->bit_buffer = (writer->bit_buffer << length) | code;
+    writer->bit_count += length;
+    return 1;
+  }
+
+  // the accumulator is full, top it up with the leading bits of the code and flush all 8 bytes.
+  // length is below 64 so bit_count is at least 1 and the shift is always valid
+  int fit = 64 - writer->bit_count;
+  writer->bit_count = length - fit;
+  storeBigEndian64(writer->output + writer->output_index, (writer->bit_buffer << fit) | (code >> writer->bit_count));
+  writer->output_index += 8;
+  writer->bit_buffer = code & ((1ULL << writer->bit_count) - 1);
+  return 1;
+}
+
+/**
+ * Function Name: packSymbols
+ * Purpose: Appends the codes of the symbols to the bit writer.
+ *  Codes are collected in a 64 bit accumulator that is flushed 8 bytes at a time into the output buffer.
+ * Parameters:
+ *  - BitWriter* writer: The writer to append to
+ *  - const unsigned char* symbols: The characters to encode
+ *  - size_t size: The amount of characters
+ *  - const EncoderTable* table: The code word and bit length of every character
+ * Return Value:
+ *  - int: -1 if a character has no code and 1 if successful
+ */
+static int packSymbols(BitWriter* writer, const unsigned char* symbols, size_t size, const EncoderTable* table) {
+  uint64_t bit_buffer = writer->bit_buffer;
+  int bit_count = writer->bit_count;
+  unsigned char* output = writer->output;
+  size_t output_index = writer->output_index;
+
+  for (size_t i = 0; i < size; i++) {
+    uint64_t code = table->codes[symbols[i]];
+    int length = table->lengths[symbols[i]];
+
+    if (length == 0) {
+      fprintf(stderr, "Error: Code not found for key '%c'\n", symbols[i]);
+      return -1;
+    }
+
+    if (bit_count + length < 64) {
+      bit_buffer = (bit_buffer << length) | code;
+      bit_count += length;
+      continue;
+    }
+
+    // the accumulator is full, top it up with the leading bits of the code and flush all 8 bytes.
+    // length is below 64 so bit_count is at least 1 and the shift is always valid
+    int fit = 64 - bit_count;
+    bit_count = length - fit;
+    storeBigEndian64(output + output_index, (bit_buffer << fit) | (code >> bit_count));
+    output_index += 8;
+    bit_buffer = code & ((1ULL << bit_count) - 1);
+  }
+
+  writer->bit_buffer = bit_buffer;
+  writer->bit_count = bit_count;
+  writer->output_index = output_index;
+  return 1;
+}
+
+/**
+ * Function Name: packStreams
+ * Purpose: Packs the streams of a block side by side, a character of every stream at a time, so the codes of
+ *  the streams are looked up and shifted in independently of each other
+ * Parameters:
+ *  - BitWriter writers[]: A writer for every stream, each writing where its stream starts in the payload
+ *  - int stream_count: The amount of streams
+ *  - const unsigned char* symbols: The characters of the block, every stream encodes a run of them
+ *  - size_t size: The amount of characters
+ *  - const EncoderTable* table: The code word and bit length of every character
+ * Return Value:
+ *  - int: -1 if a character has no code and 1 if successful
+ */
+static int packStreams(BitWriter writers[], int stream_count, const unsigned char* symbols, size_t size, const EncoderTable* table) {
+  const unsigned char* runs[HUFFMAN_MAX_STREAMS];
+  for (int k = 0; k < stream_count; k++) {
+    runs[k] = symbols + streamStart(size, stream_count, k);
+  }
+
+  // every round takes a character from every stream, the streams that are a character longer get it afterwards
+  size_t run_size = size / (size_t) stream_count;
+  for (size_t i = 0; i < run_size; i++) {
+    for (int k = 0; k < stream_count; k++) {
+      if (appendCode(&writers[k], table, runs[k][i]) == -1) {
+        return -1;
+      }
+    }
+  }
+  for (int k = 0; k < (int) (size % (size_t) stream_count); k++) {
+    if (appendCode(&writers[k], table, runs[k][run_size]) == -1) {
+      return -1;
+    }
+  }
+
+  return 1;
+}
+
+/**
+ * Function Name: alignBitWriter
+ * Purpose: Moves the bits left in the accumulator to the output buffer, padding the last byte with ones.
+ *  The all ones code is the longest canonical code, so the padding is only a complete code when every code is shorter than a byte
+ * Parameters:
+ *  - BitWriter* writer: The writer to align
+ * Return Value:
+ *  - void
+ */
+static void alignBitWriter(BitWriter* writer) {
+  if (writer->bit_count == 0) {
+    return;
+  }
+
+  int byte_count = (writer->bit_count + 7) / 8;
+  int padding = byte_count * 8 - writer->bit_count;
+  uint64_t bit_buffer = (writer->bit_buffer << padding) | ((1ULL << padding) - 1);
+  for (int i = byte_count - 1; i >= 0; i--) {
+    writer->output[writer->output_index++] = (unsigned char) (bit_buffer >> (i * 8));
+  }
+  writer->bit_buffer = 0;
+  writer->bit_count = 0;
+}
+
+/**
+ * Function Name: writeBlockIndex
+ * Purpose: Writes the block index and the footer that points to it, they let a decoder find every block without reading the ones before it
+ * Parameters:
+ *  - OutputSink* output: The compressed output, positioned after the end marker
+ *  - const BlockIndexEntry* index: The index entry of every block
+ *  - uint64_t block_count: The amount of blocks
+ *  - uint64_t index_offset: Where the index starts in the output
+ * Return Value:
+ *  - void
+ */
+static void writeBlockIndex(OutputSink* output, const BlockIndexEntry* index, uint64_t block_count, uint64_t index_offset) {
+  unsigned char entry[BLOCK_INDEX_ENTRY_SIZE];
+  for (uint64_t i = 0; i < block_count; i++) {
+    storeLittleEndian(entry, index[i].offset, 8);
+    storeLittleEndian(entry + 8, index[i].bit_length, 8);
+    storeLittleEndian(entry + 16, index[i].decoded_length, 8);
+    writeOutput(output, entry, BLOCK_INDEX_ENTRY_SIZE);
+  }
+
+  unsigned char footer[CONTAINER_FOOTER_SIZE];
+  storeLittleEndian(footer, index_offset, 8);
+  storeLittleEndian(footer + 8, block_count, 4);
+  memcpy(footer + 12, CONTAINER_FOOTER_MAGIC, 4);
+  writeOutput(output, footer, CONTAINER_FOOTER_SIZE);
+}
+
+/**
+ * Function Name: createBlockJobs
+ * Purpose: Creates the jobs of a batch, every job gets an input buffer of block_size bytes
+ * Parameters:
+ *  - int job_count: The amount of jobs
+ *  - size_t block_size: The amount of input bytes in a block
+ * Return Value:
+ *  - BlockJob*: The jobs, NULL if they could not be allocated
+ */
+static BlockJob* createBlockJobs(int job_count, size_t block_size) {
+  BlockJob* jobs = (BlockJob*) calloc((size_t) job_count, sizeof(BlockJob));
+  if (jobs == NULL) {
+    return NULL;
+  }
+
+  for (int i = 0; i < job_count; i++) {
+    jobs[i].input = (unsigned char*) malloc(block_size);
+    if (jobs[i].input == NULL) {
+      freeBlockJobs(jobs, job_count);
+      return NULL;
+    }
+  }
+
+  return jobs;
+}
+
+/**
+ * Function Name: freeBlockJobs
+ * Purpose: Frees the jobs of a batch and their buffers
+ * Parameters:
+ *  - BlockJob* jobs: The jobs, may be NULL
+ *  - int job_count: The amount of jobs
+ * Return Value:
+ *  - void
+ */
+static void freeBlockJobs(BlockJob* jobs, int job_count) {
+  if (jobs == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < job_count; i++) {
+    free(jobs[i].input);
+    free(jobs[i].output);
+  }
+  free(jobs);
+}
+
+/**
+ * Function Name: analyzeBlockTask
+ * Purpose: Pool task, normalizes a block (not in the raw mode), counts its characters and builds its own table.
+ *  With a dictionary the block is encoded with the table of the dictionary instead, and with the table cache on
+ *  a cached table close enough to the best one is taken instead of building one
+ * Parameters:
+ *  - void* argument: The BlockBatch
+ *  - int index: The block in the batch
+ * Return Value:
+ *  - void
+ */
+static void analyzeBlockTask(void* argument, int index) {
+  BlockBatch* batch = (BlockBatch*) argument;
+  BlockJob* job = &batch->jobs[index];
+  uint64_t lap = 0;
+  statsLap(batch->timed, &lap);
+
+  if (batch->mode == HUFFMAN_MODE_RAW) {
+    // every byte is a character of its own, the block is encoded straight from where it was read
+    job->symbols = job->source;
+    job->size = job->bytes_read;
+  } else {
+    // lower the string, convert whitespaces to spaces and apply the character filter in a single pass
+    job->size = normalizeBytes(job->source, job->bytes_read, job->input);
+    job->symbols = job->input;
+  }
+  job->nanoseconds[HUFFMAN_STAGE_NORMALIZE] += statsLap(batch->timed, &lap);
+
+  // the dictionary has a code for every character, so the block is not counted and its size comes from the codes
+  if (batch->dictionary != NULL) {
+    job->table = *batch->dictionary;
+    job->bit_count = symbolBitCount(job->symbols, job->size, &job->table);
+    job->nanoseconds[HUFFMAN_STAGE_TABLE] += statsLap(batch->timed, &lap);
+    return;
+  }
+
+  memset(&job->histogram, 0, sizeof(Histogram));
+  histogramCountParallel(&job->histogram, job->symbols, job->size, batch->count_threads);
+  job->nanoseconds[HUFFMAN_STAGE_HISTOGRAM] += statsLap(batch->timed, &lap);
+
+  if (job->size == 0) {
+    return;
+  }
+
+  // a table of an earlier input is taken when it costs little more than the entropy, which no table beats
+  job->cache_entry = -1;
+  if (batch->table_cache != NULL) {
+    const Alphabet* alphabet = modeAlphabet(batch->mode);
+    job->fingerprint.mode = batch->mode;
+    job->fingerprint.max_code_length = batch->max_code_length;
+    histogramFingerprint(&job->histogram, alphabet, &job->fingerprint);
+    uint64_t bit_count;
+    int entry = findCachedTable(batch->table_cache, &job->fingerprint, alphabet, &job->histogram, &bit_count);
+    if (entry != -1) {
+      uint64_t entropy = entropyBitCount(&job->histogram, alphabet);
+      if (bit_count * 100 <= entropy * (uint64_t) (100 + batch->table_cache_margin)) {
+        job->table = batch->table_cache[entry].table;
+        job->cache_entry = entry;
+        job->nanoseconds[HUFFMAN_STAGE_TABLE] += statsLap(batch->timed, &lap);
+        return;
+      }
+    }
+  }
+
+  // the alphabet is a constant in each branch, so each call can get loops of a fixed length
+  if (batch->mode == HUFFMAN_MODE_RAW) {
+    buildEncoderTable(&job->histogram, &RAW_ALPHABET, batch->max_code_length, &job->table);
+  } else {
+    buildEncoderTable(&job->histogram, &TEXT_ALPHABET, batch->max_code_length, &job->table);
+  }
+  job->nanoseconds[HUFFMAN_STAGE_TABLE] += statsLap(batch->timed, &lap);
+}
+
+/**
+ * Function Name: packBlockTask
+ * Purpose: Pool task, packs a block with the table that was chosen for it into its own output buffer
+ * Parameters:
+ *  - void* argument: The BlockBatch
+ *  - int index: The block in the batch
+ * Return Value:
+ *  - void
+ */
+static void packBlockTask(void* argument, int index) {
+  BlockBatch* batch = (BlockBatch*) argument;
+  BlockJob* job = &batch->jobs[index];
+  job->result = 1;
+
+  if (job->size == 0) {
+    return;
+  }
+
+  uint64_t lap = 0;
+  statsLap(batch->timed, &lap);
+
+  // every stream is padded on its own, so the size of all but the last one is counted before packing
+  // and each stream is packed straight to where it starts in the payload
+  int stream_count = batch->stream_count;
+  uint64_t stream_sizes[HUFFMAN_MAX_STREAMS];
+  uint64_t last_bit_count = job->bit_count;
+  job->payload_size = 0;
+  for (int k = 0; k < stream_count - 1; k++) {
+    uint64_t start = streamStart(job->size, stream_count, k);
+    uint64_t stream_bit_count = symbolBitCount(job->symbols + start, (size_t) (streamStart(job->size, stream_count, k + 1) - start), &job->table);
+    stream_sizes[k] = (stream_bit_count + 7) / 8;
+    job->payload_size += stream_sizes[k];
+    last_bit_count -= stream_bit_count;
+  }
+  stream_sizes[stream_count - 1] = (last_bit_count + 7) / 8;
+  job->payload_size += stream_sizes[stream_count - 1];
+
+  // room for the whole payload and the 8 bytes packSymbols stores at a time, so it never flushes
+  size_t capacity = (size_t) job->payload_size + 16;
+  if (capacity > job->output_capacity) {
+    free(job->output);
+    job->output = (unsigned char*) malloc(capacity);
+    job->output_capacity = job->output == NULL ? 0 : capacity;
+    job->allocations += 1;
+    if (job->output == NULL) {
+      job->result = -1;
+      return;
+    }
+  }
+
+  if (stream_count == 1) {
+    BitWriter writer = { 0 };
+    writer.output = job->output;
+    job->result = packSymbols(&writer, job->symbols, job->size, &job->table);
+    alignBitWriter(&writer);
+  } else {
+    BitWriter writers[HUFFMAN_MAX_STREAMS] = { { 0 } };
+    size_t stream_offset = 0;
+    for (int k = 0; k < stream_count; k++) {
+      writers[k].output = job->output + stream_offset;
+      stream_offset += (size_t) stream_sizes[k];
+    }
+    job->result = packStreams(writers, stream_count, job->symbols, job->size, &job->table);
+    for (int k = 0; k < stream_count; k++) {
+      alignBitWriter(&writers[k]);
+    }
+  }
+
+  // the header is written again with the padded size of the streams, the table it holds does not change
+  job->header_size = writeBlockHeader(job->header, job->block_type, job->size, job->payload_size, modeAlphabet(batch->mode), &job->table);
+  if (job->block_type == BLOCK_TYPE_DICTIONARY) {
+    storeLittleEndian(job->header + job->header_size, batch->dictionary_id, DICTIONARY_ID_BYTES);
+    job->header_size += DICTIONARY_ID_BYTES;
+  }
+  for (int k = 0; k < stream_count - 1; k++) {
+    storeLittleEndian(job->header + job->header_size, stream_sizes[k], STREAM_SIZE_BYTES);
+    job->header_size += STREAM_SIZE_BYTES;
+  }
+  job->nanoseconds[HUFFMAN_STAGE_PACK] += statsLap(batch->timed, &lap);
+}
+
+/**
+ * Function Name: encodeContainer
+ * Purpose: Compresses the input into the output, a batch of blocks at a time.
+ *  Every block is normalized, counted and encoded with its own table, or with the table of the block before it
+ *  when that takes fewer bits than storing a new one. The blocks of a batch are processed on the thread pool and
+ *  written in input order. Memory use only depends on the block size and the amount of threads.
+ *  With a dictionary every block is encoded with the table of the dictionary and nothing is counted.
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The thread pool and block buffers to use, the frequency of every character is counted in its histogram
+ *  - InputFile* input: The input file or buffer
+ *  - OutputSink* output: The output file or buffer, a file does not need to be seekable
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+static int encodeContainer(HuffmanEncoder* encoder, InputFile* input, OutputSink* output) {
+  BlockJob* jobs = encoder->jobs;
+  memset(&encoder->histogram, 0, sizeof(Histogram));
+
+  HuffmanStats* stats = &encoder->stats;
+  int timed = encoder->stats_enabled;
+  uint64_t lap = 0;
+  statsLap(timed, &lap);
+  stats->inputs += 1;
+
+  unsigned char container_header[CONTAINER_HEADER_SIZE] = { 0 };
+  memcpy(container_header, CONTAINER_MAGIC, 4);
+  container_header[4] = CONTAINER_VERSION;
+  container_header[5] = (unsigned char) encoder->mode;
+  container_header[6] = (unsigned char) encoder->stream_count;
+  writeOutput(output, container_header, CONTAINER_HEADER_SIZE);
+
+  EncoderTable previous_table;
+  int has_previous_table = 0;
+  const Alphabet* alphabet = modeAlphabet(encoder->mode);
+  BlockBatch batch = { jobs, 1, encoder->max_code_length, encoder->mode, encoder->stream_count, timed,
+                       encoder->has_dictionary ? &encoder->dictionary_table : NULL, encoder->dictionary.id,
+                       encoder->table_cache_margin != TABLE_CACHE_OFF ? encoder->table_cache : NULL, encoder->table_cache_margin };
+  int result = 1;
+
+  // the index is the only thing that grows with the input, 24 bytes per block
+  BlockIndexEntry* index = NULL;
+  uint64_t index_count = 0;
+  uint64_t index_capacity = 0;
+  uint64_t offset = CONTAINER_HEADER_SIZE;
+
+  while (result == 1) {
+    int block_count = 0;
+    while (block_count < encoder->batch_capacity) {
+      jobs[block_count].bytes_read = readInputBlock(input, jobs[block_count].input, encoder->block_size, &jobs[block_count].source);
+      if (jobs[block_count].bytes_read == 0) {
+        break;
+      }
+      block_count += 1;
+    }
+    stats->nanoseconds[HUFFMAN_STAGE_READ] += statsLap(timed, &lap);
+
+    if (block_count == 0) {
+      break;
+    }
+
+    // the stages on the thread pool are timed by the jobs themselves
+    batch.count_threads = block_count == 1 ? encoder->thread_count : 1;
+    threadPoolRun(encoder->pool, analyzeBlockTask, &batch, block_count);
+    statsLap(timed, &lap);
+
+    for (int i = 0; i < block_count; i++) {
+      BlockJob* job = &jobs[i];
+      if (job->size == 0) {
+        continue;
+      }
+
+      // the first block names the dictionary, the blocks after it reuse its table
+      if (batch.dictionary != NULL) {
+        job->block_type = has_previous_table ? BLOCK_TYPE_REUSE_TABLE : BLOCK_TYPE_DICTIONARY;
+        has_previous_table = 1;
+        continue;
+      }
+      histogramMerge(&encoder->histogram, &job->histogram);
+
+      // the headers only give the size of the table here, packBlockTask writes them again with the size of the streams
+      uint64_t bit_count = encodedBitCount(&job->histogram, alphabet, &job->table);
+      job->block_type = BLOCK_TYPE_NEW_TABLE;
+      job->header_size = writeBlockHeader(job->header, BLOCK_TYPE_NEW_TABLE, job->size, (bit_count + 7) / 8, alphabet, &job->table);
+
+      // small blocks are often cheaper with the previous table than with a table of their own
+      if (has_previous_table) {
+        uint64_t reuse_bit_count = encodedBitCount(&job->histogram, alphabet, &previous_table);
+        if (reuse_bit_count != UINT64_MAX && reuse_bit_count <= bit_count + (job->header_size - BLOCK_HEADER_SIZE) * 8) {
+          bit_count = reuse_bit_count;
+          job->table = previous_table;
+          job->block_type = BLOCK_TYPE_REUSE_TABLE;
+        }
+      }
+
+      job->bit_count = bit_count;
+      previous_table = job->table;
+      has_previous_table = 1;
+
+      // the cache is only read while the batch runs, the tables this input builds are added once it is done
+      if (job->block_type == BLOCK_TYPE_NEW_TABLE && job->cache_entry != -1) {
+        encoder->table_cache[job->cache_entry].last_use = ++encoder->table_cache_clock;
+      } else if (job->block_type == BLOCK_TYPE_NEW_TABLE && batch.table_cache != NULL && encoder->new_table_count < TABLE_CACHE_SIZE
+                 && findTableFingerprint(encoder->new_tables, encoder->new_table_count, &job->fingerprint) == -1) {
+        encoder->new_tables[encoder->new_table_count].fingerprint = job->fingerprint;
+        encoder->new_tables[encoder->new_table_count].table = job->table;
+        encoder->new_tables[encoder->new_table_count].last_use = 1;
+        encoder->new_table_count += 1;
+      }
+    }
+    stats->nanoseconds[HUFFMAN_STAGE_TABLE] += statsLap(timed, &lap);
+
+    threadPoolRun(encoder->pool, packBlockTask, &batch, block_count);
+    statsLap(timed, &lap);
+
+    for (int i = 0; i < block_count; i++) {
+      BlockJob* job = &jobs[i];
+      for (int stage = 0; stage < HUFFMAN_STAGE_COUNT; stage++) {
+        stats->nanoseconds[stage] += job->nanoseconds[stage];
+        job->nanoseconds[stage] = 0;
+      }
+      stats->allocations += job->allocations;
+      job->allocations = 0;
+      stats->input_bytes += job->bytes_read;
+      if (job->size != 0) {
+        stats->blocks += 1;
+        stats->symbols += job->size;
+        stats->new_tables += job->block_type == BLOCK_TYPE_NEW_TABLE;
+        stats->cached_tables += job->block_type == BLOCK_TYPE_NEW_TABLE && job->cache_entry != -1;
+      }
+    }
+
+    // the blocks are written in input order
+    for (int i = 0; i < block_count; i++) {
+      BlockJob* job = &jobs[i];
+      if (job->size == 0) {
+        continue;
+      }
+      if (job->result == -1) {
+        result = -1;
+        break;
+      }
+
+      if (index_count == index_capacity) {
+        index_capacity = index_capacity == 0 ? 64 : index_capacity * 2;
+        BlockIndexEntry* grown = (BlockIndexEntry*) realloc(index, (size_t) index_capacity * sizeof(BlockIndexEntry));
+        stats->allocations += 1;
+        if (grown == NULL) {
+          fprintf(stderr, "An error has occured while allocating memory.\n");
+          result = -1;
+          break;
+        }
+        index = grown;
+      }
+      index[index_count].offset = offset;
+      index[index_count].bit_length = job->bit_count;
+      index[index_count].decoded_length = job->size;
+      index_count += 1;
+
+      writeOutput(output, job->header, job->header_size);
+      writeOutput(output, job->output, (size_t) job->payload_size);
+      offset += job->header_size + job->payload_size;
+    }
+
+    // the batch is done with the mapped input it read
+    releaseInput(input);
+
+    if (output->error) {
+      result = -1;
+    }
+    stats->nanoseconds[HUFFMAN_STAGE_WRITE] += statsLap(timed, &lap);
+  }
+
+  if (input->error) {
+    perror("Error reading the input file");
+    result = -1;
+  }
+
+  unsigned char end_marker = BLOCK_TYPE_END;
+  writeOutput(output, &end_marker, 1);
+  writeBlockIndex(output, index, index_count, offset + 1);
+  free(index);
+  updateTableCache(encoder);
+  stats->output_bytes += offset + 1 + index_count * BLOCK_INDEX_ENTRY_SIZE + CONTAINER_FOOTER_SIZE;
+
+  if (output->file != NULL && (fflush(output->file) != 0 || ferror(output->file))) {
+    perror("Error writing the compressed file");
+    result = -1;
+  } else if (output->error) {
+    fprintf(stderr, "The output buffer is too small for the compressed data\n");
+    result = -1;
+  }
+  stats->nanoseconds[HUFFMAN_STAGE_WRITE] += statsLap(timed, &lap);
+
+  return result;
+}
+
+// TABLE DRIVEN DECODER
+// the primary table is indexed by the next DECODE_TABLE_BITS bits of the stream
+#define DECODE_TABLE_BITS 11
+#define DECODE_TABLE_SIZE (1 << DECODE_TABLE_BITS)
+
+// codes longer than the primary table continue in subtables of at most this many bits
+#define DECODE_SUBTABLE_MAX_BITS 8
+
+// a primary entry holds every code that fits completely in its window, up to this many
+#define DECODE_MAX_SYMBOLS_PER_ENTRY 4
+
+typedef struct DecodeEntry {
+  unsigned char symbols[DECODE_MAX_SYMBOLS_PER_ENTRY];
+  uint8_t ends[DECODE_MAX_SYMBOLS_PER_ENTRY]; // bits consumed once the matching symbol is decoded
+  uint8_t symbol_count; // 0 if the window is the start of a longer code (or not a code at all)
+  uint8_t subtable_bits; // width of the subtable the longer code continues in, 0 if there is none
+  uint32_t subtable; // offset of that subtable in DecodeTable.subtables
+} DecodeEntry;
+
+typedef struct DecodeSubEntry {
+  unsigned char symbol;
+  uint8_t bits; // bits of the code that belong to this level
+  uint8_t subtable_bits; // non zero if the code continues in another subtable
+  uint32_t subtable;
+} DecodeSubEntry;
+
+typedef struct DecodeTable {
+  DecodeEntry primary[DECODE_TABLE_SIZE];
+  DecodeSubEntry* subtables;
+  size_t subtables_size;
+  size_t subtables_capacity;
+} DecodeTable;
+
+typedef struct DecodeCode {
+  uint64_t code;
+  int length;
+  unsigned char symbol;
+} DecodeCode;
+
+static int assignDecodeCodes(const uint8_t lengths[], const Alphabet* alphabet, DecodeCode codes[]);
+static int64_t buildDecodeSubtable(DecodeTable* table, DecodeCode* codes, size_t count, int depth, int bits);
+static int buildDecodeTable(DecodeTable* table, const uint8_t lengths[], const Alphabet* alphabet);
+static void freeDecodeTable(DecodeTable* table);
+static inline uint64_t peekBits(const unsigned char* data, uint64_t bit_position);
+
+/**
+ * Function Name: assignDecodeCodes
+ * Purpose: Rebuilds the canonical codes from the code lengths, in the order the encoder assigned them.
+ *  That order (by length, then by character) is also the sorted order of the codes. The codes are counted per
+ *  length first, so every character is only visited twice.
+ * Parameters:
+ *  - const uint8_t lengths[]: The code length of every character below 64, 0 if the character has no code
+ *  - const Alphabet* alphabet: The characters that can have a code
+ *  - DecodeCode codes[]: The codes, at least 256 entries
+ * Return Value:
+ *  - int: the amount of codes, -1 if the lengths do not describe a valid prefix code
+ */
+static int assignDecodeCodes(const uint8_t lengths[], const Alphabet* alphabet, DecodeCode codes[]) {
+  int length_counts[64] = { 0 };
+  for (int i = 0; i < alphabet->size; i++) {
+    length_counts[lengths[alphabet->characters[i]]]++;
+  }
+  length_counts[0] = 0;
+
+  // the first code and the first position of every length follow the ones of the length before it
+  uint64_t next_code[64];
+  int next_position[64];
+  uint64_t code = 0;
+  int count = 0;
+  for (int length = 1; length < 64; length++) {
+    code = (code + (uint64_t) length_counts[length - 1]) << 1;
+
+    // more codes of this length than there is room for
+    if (length_counts[length] != 0 && (code + (uint64_t) length_counts[length] - 1) >> length != 0) {
+      return -1;
+    }
+
+    next_code[length] = code;
+    next_position[length] = count;
+    count += length_counts[length];
+  }
+
+  for (int i = 0; i < alphabet->size; i++) {
+    unsigned char c = alphabet->characters[i];
+    int length = lengths[c];
+    if (length == 0) {
+      continue;
+    }
+
+    int position = next_position[length]++;
+    codes[position].code = next_code[length]++;
+    codes[position].length = length;
+    codes[position].symbol = c;
+  }
+
+  return count;
+}
+
+/**
+ * Function Name: buildDecodeSubtable
+ * Purpose: Appends a subtable for codes that share their first depth bits
+ * Parameters:
+ *  - DecodeTable* table: The table the subtable is added to
+ *  - DecodeCode* codes: The codes that continue in this subtable, in canonical order
+ *  - size_t count: The amount of codes
+ *  - int depth: The amount of bits already consumed by earlier levels
+ *  - int bits: The width of the subtable
+ * Return Value:
+ *  - int64_t: the offset of the subtable, -1 if memory could not be allocated
+ */
+static int64_t buildDecodeSubtable(DecodeTable* table, DecodeCode* codes, size_t count, int depth, int bits) {
+  size_t entries = (size_t) 1 << bits;
+
+  if (table->subtables_size + entries > table->subtables_capacity) {
+    size_t capacity = table->subtables_capacity * 2 + entries;
+    DecodeSubEntry* temp = (DecodeSubEntry*) realloc(table->subtables, capacity * sizeof(DecodeSubEntry));
+    if (temp == NULL) {
+      fprintf(stderr, "Failed to allocate memory for the decode subtables\n");
+      return -1;
+    }
+    table->subtables = temp;
+    table->subtables_capacity = capacity;
+  }
+
+  size_t offset = table->subtables_size;
+  table->subtables_size += entries;
+  memset(table->subtables + offset, 0, entries * sizeof(DecodeSubEntry));
+
+  size_t i = 0;
+  while (i < count) {
+    int remaining = codes[i].length - depth;
+    // the bits of this code that index this subtable, left aligned in the subtable width
+    uint64_t below_depth = codes[i].code & ((1ULL << remaining) - 1);
+
+    if (remaining <= bits) {
+      size_t first = (size_t) (below_depth << (bits - remaining));
+      size_t last = first + ((size_t) 1 << (bits - remaining));
+      for (size_t index = first; index < last; index++) {
+        table->subtables[offset + index].symbol = codes[i].symbol;
+        table->subtables[offset + index].bits = (uint8_t) remaining;
+      }
+      i += 1;
+      continue;
+    }
+
+    // every code sharing the same next bits continues in one deeper subtable
+    size_t index = (size_t) (below_depth >> (remaining - bits));
+    size_t group_end = i;
+    int longest = 0;
+    while (group_end < count) {
+      int group_remaining = codes[group_end].length - depth;
+      if (group_remaining <= bits || ((codes[group_end].code >> (group_remaining - bits)) & (entries - 1)) != index) {
+        break;
+      }
+      if (codes[group_end].length > longest) {
+        longest = codes[group_end].length;
+      }
+      group_end += 1;
+    }
+
+    int next_bits = longest - depth - bits;
+    if (next_bits > DECODE_SUBTABLE_MAX_BITS) {
+      next_bits = DECODE_SUBTABLE_MAX_BITS;
+    }
+
+    int64_t next = buildDecodeSubtable(table, codes + i, group_end - i, depth + bits, next_bits);
+    if (next == -1) {
+      return -1;
+    }
+
+    table->subtables[offset + index].bits = (uint8_t) bits;
+    table->subtables[offset + index].subtable_bits = (uint8_t) next_bits;
+    table->subtables[offset + index].subtable = (uint32_t) next;
+    i = group_end;
+  }
+
+  return (int64_t) offset;
+}
+
+/**
+ * Function Name: buildDecodeTable
+ * Purpose: Builds the lookup tables directly from the code lengths.
+ *  Every primary entry decodes as many complete codes as fit in its window, longer codes continue in subtables.
+ *  The table is reused from an earlier block, the subtables keep the memory they already have.
+ * Parameters:
+ *  - DecodeTable* table: The table to build, its old contents are discarded
+ *  - const uint8_t lengths[]: The code length of every character, 0 if the character has no code
+ *  - const Alphabet* alphabet: The characters that can have a code
+ * Return Value:
+ *  - int: -1 if the table could not be built and 1 if successful
+ */
+static int buildDecodeTable(DecodeTable* table, const uint8_t lengths[], const Alphabet* alphabet) {
+  memset(table->primary, 0, sizeof(table->primary));
+  table->subtables_size = 0;
+
+  // canonical codes are already sorted, codes sharing a prefix are next to each other
+  DecodeCode codes[256];
+  int assigned = assignDecodeCodes(lengths, alphabet, codes);
+  if (assigned == -1) {
+    fprintf(stderr, "The code lengths do not describe a valid prefix code\n");
+    return -1;
+  }
+  size_t count = (size_t) assigned;
+
+  // first place every code in the windows it is a prefix of, one symbol per entry
+  size_t i = 0;
+  while (i < count) {
+    if (codes[i].length <= DECODE_TABLE_BITS) {
+      size_t first = (size_t) (codes[i].code << (DECODE_TABLE_BITS - codes[i].length));
+      size_t last = first + ((size_t) 1 << (DECODE_TABLE_BITS - codes[i].length));
+      for (size_t index = first; index < last; index++) {
+        table->primary[index].symbols[0] = codes[i].symbol;
+        table->primary[index].ends[0] = (uint8_t) codes[i].length;
+        table->primary[index].symbol_count = 1;
+      }
+      i += 1;
+      continue;
+    }
+
+    size_t index = (size_t) (codes[i].code >> (codes[i].length - DECODE_TABLE_BITS));
+    size_t group_end = i;
+    int longest = 0;
+    while (group_end < count && codes[group_end].length > DECODE_TABLE_BITS &&
+           (size_t) (codes[group_end].code >> (codes[group_end].length - DECODE_TABLE_BITS)) == index) {
+      if (codes[group_end].length > longest) {
+        longest = codes[group_end].length;
+      }
+      group_end += 1;
+    }
+
+    int bits = longest - DECODE_TABLE_BITS;
+    if (bits > DECODE_SUBTABLE_MAX_BITS) {
+      bits = DECODE_SUBTABLE_MAX_BITS;
+    }
+
+    int64_t subtable = buildDecodeSubtable(table, codes + i, group_end - i, DECODE_TABLE_BITS, bits);
+    if (subtable == -1) {
+      return -1;
+    }
+
+    table->primary[index].subtable_bits = (uint8_t) bits;
+    table->primary[index].subtable = (uint32_t) subtable;
+    i = group_end;
+  }
+
+  // then let every entry keep decoding while the next code still fits completely in the window.
+  // the entries are only read here, the window shifted by the bits already used is another index
+  // of the same table where the bits past the window are zero, so a match only counts if its code fits
+  DecodeEntry extended[DECODE_TABLE_SIZE];
+  for (size_t index = 0; index < DECODE_TABLE_SIZE; index++) {
+    extended[index] = table->primary[index];
+    DecodeEntry* entry = &extended[index];
+    if (entry->symbol_count == 0) {
+      continue;
+    }
+
+    while (entry->symbol_count < DECODE_MAX_SYMBOLS_PER_ENTRY) {
+      int used = entry->ends[entry->symbol_count - 1];
+      const DecodeEntry* next = &table->primary[(index << used) & (DECODE_TABLE_SIZE - 1)];
+      if (next->symbol_count == 0 || used + next->ends[0] > DECODE_TABLE_BITS) {
+        break;
+      }
+
+      entry->symbols[entry->symbol_count] = next->symbols[0];
+      entry->ends[entry->symbol_count] = (uint8_t) (used + next->ends[0]);
+      entry->symbol_count += 1;
+    }
+  }
+  memcpy(table->primary, extended, sizeof(extended));
+
+  return 1;
+}
+
+/**
+ * Function Name: freeDecodeTable
+ * Purpose: Frees the subtables of a decode table, the table itself belongs to the decoder
+ * Parameters:
+ *  - DecodeTable* table: The table whose subtables are freed
+ * Return Value:
+ *  - void
+ */
+static void freeDecodeTable(DecodeTable* table) {
+  free(table->subtables);
+  table->subtables = NULL;
+  table->subtables_size = 0;
+  table->subtables_capacity = 0;
+}
+
+/**
+ * Function Name: peekBits
+ * Purpose: Returns the 64 bits starting at bit_position, the first bit is the most significant one.
+ *  Only the first 57 bits are guaranteed, the data must be followed by 8 readable bytes.
+ * Parameters:
+ *  - const unsigned char* data: The compressed data
+ *  - uint64_t bit_position: The position of the first bit
+ * Return Value:
+ *  - uint64_t: the bits
+ */
+static inline uint64_t peekBits(const unsigned char* data, uint64_t bit_position) {
+  uint64_t word;
+  memcpy(&word, data + (bit_position >> 3), sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word << (bit_position & 7);
+}
+
+// PARALLEL BLOCK DECODER
+// the block index gives the position of every block and of its characters in the output,
+// so the tables are built and the blocks decoded on the thread pool, each block into its own slice of the output
+typedef struct DecodeBlock {
+  BlockIndexEntry entry;
+  BlockHeader header;
+  uint8_t lengths[256]; // only for blocks with a new table or a dictionary
+  DecodeTable* table; // only for blocks with a new table or a dictionary
+  uint64_t table_block; // the block whose table this block is decoded with
+  int cache_entry; // only for blocks with a new table, the table cache entry it is decoded with, -1 if it is built
+  uint64_t output_offset; // where the characters of the block start in the output
+  uint64_t table_nanoseconds; // time of the stages that ran on the thread pool
+  uint64_t decode_nanoseconds;
+  uint64_t allocations;
+  int result;
+} DecodeBlock;
+
+// a decode table built for an earlier input, found by the code lengths it was built from
+typedef struct DecodeCacheEntry {
+  int mode;
+  uint8_t lengths[256];
+  DecodeTable table;
+  uint64_t last_use; // 0 for an empty entry, the entry used longest ago is replaced first
+} DecodeCacheEntry;
+
+typedef struct DecodeJob {
+  const unsigned char* data; // the contents of compressed.bin
+  DecodeBlock* blocks;
+  unsigned char* output;
+  int mode; // from the container header
+  int timed; // 1 if the statistics are on
+} DecodeJob;
+
+struct HuffmanDecoder {
+  ThreadPool* pool;
+  DecodeTable* tables; // one for every block with a new table, kept for the next input together with their subtables
+  size_t table_capacity;
+  int has_dictionary;
+  HuffmanDictionary dictionary;
+  DecodeTable dictionary_table; // built once when the dictionary is set
+  DecodeCacheEntry* table_cache; // TABLE_CACHE_SIZE entries, allocated when the first table is cached
+  uint64_t table_cache_clock;
+  int stats_enabled;
+  HuffmanStats stats;
+};
+
+// DECODING LOGIC
+static inline int decodeLongCode(const DecodeTable* table, const DecodeEntry* entry, const unsigned char* payload, uint64_t bit_position, uint64_t window, unsigned char* symbol);
+static uint64_t decodeSymbols(const DecodeTable* table, const unsigned char* payload, uint64_t payload_bits, uint64_t bit_position, unsigned char* output, uint64_t symbol_count);
+static uint64_t decodeStreams(const DecodeTable* table, const unsigned char* payload, const BlockHeader* header, unsigned char* output);
+static int readContainerHeader(const unsigned char* data, size_t size);
+static int readBlockHeader(const unsigned char* data, size_t size, size_t offset, int mode, int stream_count, BlockHeader* header, uint8_t lengths[]);
+static DecodeBlock* readBlockIndex(const unsigned char* data, size_t size, uint64_t* block_count, uint64_t* index_offset);
+static DecodeBlock* readContainer(const unsigned char* data, size_t size, uint64_t* block_count, uint64_t* total_length);
+static void buildTableTask(void* argument, int index);
+static void decodeBlockTask(void* argument, int index);
+static int reserveDecodeTables(HuffmanDecoder* decoder, uint64_t table_count);
+static int findDecodeTable(const HuffmanDecoder* decoder, int mode, const uint8_t lengths[]);
+static void cacheDecodeTables(HuffmanDecoder* decoder, DecodeBlock* blocks, uint64_t block_count, int mode);
+static int decodeContainer(HuffmanDecoder* decoder, const unsigned char* data, DecodeBlock* blocks, uint64_t block_count, unsigned char* output);
+
+/**
+ * Function Name: decodeLongCode
+ * Purpose: Follows the subtables of a code that is longer than the primary table
+ * Parameters:
+ *  - const DecodeTable* table: The decode table
+ *  - const DecodeEntry* entry: The primary entry of the code, it has a subtable
+ *  - const unsigned char* payload: The bitstream
+ *  - uint64_t bit_position: Where the code starts
+ *  - uint64_t window: The 64 bits at bit_position
+ *  - unsigned char* symbol: Set to the character of the code
+ * Return Value:
+ *  - int: the length of the code, 0 if the bits are not a code
+ */
+static inline int decodeLongCode(const DecodeTable* table, const DecodeEntry* entry, const unsigned char* payload, uint64_t bit_position, uint64_t window, unsigned char* symbol) {
+  int length = DECODE_TABLE_BITS;
+  int bits = entry->subtable_bits;
+  const DecodeSubEntry* sub_entry = &table->subtables[entry->subtable + ((window << length) >> (64 - bits))];
+  while (sub_entry->subtable_bits != 0) {
+    length += sub_entry->bits;
+    bits = sub_entry->subtable_bits;
+    if (length + bits > 57) {
+      window = peekBits(payload, bit_position + length);
+      sub_entry = &table->subtables[sub_entry->subtable + (window >> (64 - bits))];
+      window = peekBits(payload, bit_position);
+    } else {
+      sub_entry = &table->subtables[sub_entry->subtable + ((window << length) >> (64 - bits))];
+    }
+  }
+
+  if (sub_entry->bits == 0) {
+    return 0;
+  }
+  *symbol = sub_entry->symbol;
+  return length + sub_entry->bits;
+}
+
+/**
+ * Function Name: decodeSymbols
+ * Purpose: Decodes exactly symbol_count characters from a huffman bitstream.
+ *  Every probe of the primary table decodes all codes that fit in the next DECODE_TABLE_BITS bits.
+ * Parameters:
+ *  - const DecodeTable* table: The decode table built from the code lengths
+ *  - const unsigned char* payload: The bitstream, followed by at least 16 readable bytes
+ *  - uint64_t payload_bits: The amount of bits in the bitstream
+ *  - uint64_t bit_position: Where decoding starts in the bitstream
+ *  - unsigned char* output: Room for symbol_count characters
+ *  - uint64_t symbol_count: The amount of characters to decode
+ * Return Value:
+ *  - uint64_t: the amount of characters decoded, less than symbol_count if the bitstream is damaged
+ */
+static uint64_t decodeSymbols(const DecodeTable* table, const unsigned char* payload, uint64_t payload_bits, uint64_t bit_position, unsigned char* output, uint64_t symbol_count) {
+  uint64_t decoded = 0;
+
+  while (decoded < symbol_count) {
+    uint64_t remaining_bits = payload_bits - bit_position;
+    uint64_t window = peekBits(payload, bit_position);
+    const DecodeEntry* entry = &table->primary[window >> (64 - DECODE_TABLE_BITS)];
+
+    if (entry->symbol_count != 0) {
+      // the last entry may hold codes that were only formed by the padding, stop at the last real character
+      int symbols = entry->symbol_count;
+      if ((uint64_t) symbols > symbol_count - decoded) {
+        symbols = (int) (symbol_count - decoded);
+      }
+
+      if (entry->ends[symbols - 1] > remaining_bits) {
+        break;
+      }
+
+      // a full copy is faster, but at the end it would write into the output of the next block
+      if (symbol_count - decoded >= DECODE_MAX_SYMBOLS_PER_ENTRY) {
+        memcpy(output + decoded, entry->symbols, DECODE_MAX_SYMBOLS_PER_ENTRY);
+      } else {
+        memcpy(output + decoded, entry->symbols, (size_t) symbols);
+      }
+      decoded += (uint64_t) symbols;
+      bit_position += entry->ends[symbols - 1];
+      continue;
+    }
+
+    if (entry->subtable_bits == 0) {
+      break; // not the start of any code
+    }
+
+    // the code is longer than the window, follow the subtables
+    int length = decodeLongCode(table, entry, payload, bit_position, window, output + decoded);
+    if (length == 0 || (uint64_t) length > remaining_bits) {
+      break;
+    }
+
+    decoded += 1;
+    bit_position += (uint64_t) length;
+  }
+
+  return decoded;
+}
+
+/**
+ * Function Name: decodeStreams
+ * Purpose: Decodes the streams of a block side by side. Each round decodes a table probe of every stream, and since
+ *  the streams do not depend on each other the lookups of a round overlap instead of waiting on one another.
+ *  The last characters of every stream are decoded with decodeSymbols, which checks for the end of the stream.
+ * Parameters:
+ *  - const DecodeTable* table: The decode table built from the code lengths
+ *  - const unsigned char* payload: The streams of the block, followed by at least 16 readable bytes
+ *  - const BlockHeader* header: The amount of characters and the size of every stream
+ *  - unsigned char* output: Room for the characters of the block
+ * Return Value:
+ *  - uint64_t: the amount of characters decoded, less than the characters of the block if a stream is damaged
+ */
+static uint64_t decodeStreams(const DecodeTable* table, const unsigned char* payload, const BlockHeader* header, unsigned char* output) {
+  int stream_count = header->stream_count;
+  const unsigned char* streams[HUFFMAN_MAX_STREAMS];
+  uint64_t stream_bits[HUFFMAN_MAX_STREAMS];
+  uint64_t bit_positions[HUFFMAN_MAX_STREAMS];
+  uint64_t positions[HUFFMAN_MAX_STREAMS]; // where the next character of every stream goes in the output
+  uint64_t ends[HUFFMAN_MAX_STREAMS];
+
+  size_t stream_offset = 0;
+  for (int k = 0; k < stream_count; k++) {
+    streams[k] = payload + stream_offset;
+    stream_bits[k] = header->stream_sizes[k] * 8;
+    stream_offset += (size_t) header->stream_sizes[k];
+    bit_positions[k] = 0;
+    positions[k] = streamStart(header->symbol_count, stream_count, k);
+    ends[k] = streamStart(header->symbol_count, stream_count, k + 1);
+  }
+
+  int damaged = 0;
+  while (!damaged) {
+    // a probe decodes at most DECODE_MAX_SYMBOLS_PER_ENTRY characters from less than 64 bits,
+    // so this many rounds can not reach the end of any stream and need no checks
+    uint64_t rounds = UINT64_MAX;
+    for (int k = 0; k < stream_count; k++) {
+      uint64_t stream_rounds = (ends[k] - positions[k]) / DECODE_MAX_SYMBOLS_PER_ENTRY;
+      if ((stream_bits[k] - bit_positions[k]) / 64 < stream_rounds) {
+        stream_rounds = (stream_bits[k] - bit_positions[k]) / 64;
+      }
+      if (stream_rounds < rounds) {
+        rounds = stream_rounds;
+      }
+    }
+    if (rounds == 0) {
+      break;
+    }
+
+    for (; rounds > 0 && !damaged; rounds--) {
+      for (int k = 0; k < stream_count; k++) {
+        uint64_t window = peekBits(streams[k], bit_positions[k]);
+        const DecodeEntry* entry = &table->primary[window >> (64 - DECODE_TABLE_BITS)];
+
+        if (entry->symbol_count != 0) {
+          memcpy(output + positions[k], entry->symbols, DECODE_MAX_SYMBOLS_PER_ENTRY);
+          positions[k] += entry->symbol_count;
+          bit_positions[k] += entry->ends[entry->symbol_count - 1];
+          continue;
+        }
+
+        int length = entry->subtable_bits == 0 ? 0 : decodeLongCode(table, entry, streams[k], bit_positions[k], window, output + positions[k]);
+        if (length == 0) {
+          // decodeSymbols stops at the same code and reports the stream as short
+          damaged = 1;
+          break;
+        }
+        positions[k] += 1;
+        bit_positions[k] += (uint64_t) length;
+      }
+    }
+  }
+
+  uint64_t decoded = 0;
+  for (int k = 0; k < stream_count; k++) {
+    uint64_t start = streamStart(header->symbol_count, stream_count, k);
+    decoded += positions[k] - start;
+    decoded += decodeSymbols(table, streams[k], stream_bits[k], bit_positions[k], output + positions[k], ends[k] - positions[k]);
+  }
+
+  return decoded;
+}
+
+/**
+ * Function Name: readContainerHeader
+ * Purpose: Validates the header at the start of compressed.bin
+ * Parameters:
+ *  - const unsigned char* data: The contents of the file
+ *  - size_t size: The size of the file
+ * Return Value:
+ *  - int: -1 if the header is invalid and 1 if successful
+ */
+static int readContainerHeader(const unsigned char* data, size_t size) {
+  if (size < CONTAINER_HEADER_SIZE || memcmp(data, CONTAINER_MAGIC, 4) != 0) {
+    fprintf(stderr, "The file is not a compressed file\n");
+    return -1;
+  }
+
+  if (data[4] != CONTAINER_VERSION) {
+    fprintf(stderr, "Unsupported compressed file version %d\n", data[4]);
+    return -1;
+  }
+
+  // the blocks decode the same way in both modes, the mode only says what the characters are
+  if (data[5] != HUFFMAN_MODE_TEXT && data[5] != HUFFMAN_MODE_RAW) {
+    fprintf(stderr, "Unsupported compressed file mode %d\n", data[5]);
+    return -1;
+  }
+
+  if (data[6] < 1 || data[6] > HUFFMAN_MAX_STREAMS) {
+    fprintf(stderr, "Unsupported amount of streams %d\n", data[6]);
+    return -1;
+  }
+
+  return 1;
+}
+
+/**
+ * Function Name: readBlockHeader
+ * Purpose: Parses and validates the header of a block
+ * Parameters:
+ *  - const unsigned char* data: The contents of the file
+ *  - size_t size: The size of the file
+ *  - size_t offset: Where the block starts
+ *  - int mode: The mode from the container header, a text block can only have codes for encodable characters
+ *  - int stream_count: The amount of streams from the container header
+ *  - BlockHeader* header: Set to the fields of the block header
+ *  - uint8_t lengths[]: Set to the code length of every character if the block has a new table, untouched otherwise
+ * Return Value:
+ *  - int: -1 if the header is invalid and 1 if successful
+ */
+static int readBlockHeader(const unsigned char* data, size_t size, size_t offset, int mode, int stream_count, BlockHeader* header, uint8_t lengths[]) {
+  if (offset >= size) {
+    fprintf(stderr, "The compressed file ends before its last block\n");
+    return -1;
+  }
+
+  header->block_type = data[offset];
+  if (header->block_type == BLOCK_TYPE_END) {
+    return 1;
+  }
+
+  if (header->block_type != BLOCK_TYPE_NEW_TABLE && header->block_type != BLOCK_TYPE_REUSE_TABLE && header->block_type != BLOCK_TYPE_DICTIONARY) {
+    fprintf(stderr, "Unknown block type %d\n", header->block_type);
+    return -1;
+  }
+
+  if (size - offset < BLOCK_HEADER_SIZE) {
+    fprintf(stderr, "The compressed file ends before its last block\n");
+    return -1;
+  }
+
+  header->symbol_count = loadLittleEndian(data + offset + 1, 4);
+  header->payload_size = loadLittleEndian(data + offset + 5, 4);
+  header->payload_offset = offset + BLOCK_HEADER_SIZE;
+
+  if (header->block_type == BLOCK_TYPE_NEW_TABLE) {
+    if (size - header->payload_offset < 2) {
+      fprintf(stderr, "The code length table is damaged\n");
+      return -1;
+    }
+
+    size_t code_count = (size_t) loadLittleEndian(data + header->payload_offset, 2);
+    if (code_count > 256 || (size - header->payload_offset - 2) / 2 < code_count) {
+      fprintf(stderr, "The code length table is damaged\n");
+      return -1;
+    }
+
+    memset(lengths, 0, 256);
+    const unsigned char* pairs = data + header->payload_offset + 2;
+    for (size_t i = 0; i < code_count; i++) {
+      if (pairs[i * 2 + 1] == 0 || pairs[i * 2 + 1] >= 64) {
+        fprintf(stderr, "The code length table is damaged\n");
+        return -1;
+      }
+
+      // an encodable character normalizes to itself
+      unsigned char c = pairs[i * 2];
+      if (mode == HUFFMAN_MODE_TEXT && (c == 0 || NORMALIZE_TABLE[c] != c)) {
+        fprintf(stderr, "The code length table is damaged\n");
+        return -1;
+      }
+      lengths[pairs[i * 2]] = pairs[i * 2 + 1];
+    }
+    header->payload_offset += 2 + code_count * 2;
+  } else if (header->block_type == BLOCK_TYPE_DICTIONARY) {
+    if (size - header->payload_offset < DICTIONARY_ID_BYTES) {
+      fprintf(stderr, "The compressed file ends before its last block\n");
+      return -1;
+    }
+    header->dictionary_id = (uint32_t) loadLittleEndian(data + header->payload_offset, DICTIONARY_ID_BYTES);
+    header->payload_offset += DICTIONARY_ID_BYTES;
+  }
+
+  // the last stream takes what the others leave of the payload
+  header->stream_count = stream_count;
+  if ((size - header->payload_offset) / STREAM_SIZE_BYTES < (size_t) (stream_count - 1)) {
+    fprintf(stderr, "The compressed file ends before its last block\n");
+    return -1;
+  }
+  uint64_t remaining = header->payload_size;
+  for (int k = 0; k < stream_count - 1; k++) {
+    header->stream_sizes[k] = loadLittleEndian(data + header->payload_offset, STREAM_SIZE_BYTES);
+    header->payload_offset += STREAM_SIZE_BYTES;
+    if (header->stream_sizes[k] > remaining) {
+      fprintf(stderr, "The stream sizes of a block are damaged\n");
+      return -1;
+    }
+    remaining -= header->stream_sizes[k];
+  }
+  header->stream_sizes[stream_count - 1] = remaining;
+
+  if (header->payload_size > size - header->payload_offset) {
+    fprintf(stderr, "The compressed data is shorter than the header claims\n");
+    return -1;
+  }
+
+  return 1;
+}
+
+/**
+ * Function Name: readBlockIndex
+ * Purpose: Reads the footer at the end of compressed.bin and the block index it points to
+ * Parameters:
+ *  - const unsigned char* data: The contents of the file
+ *  - size_t size: The size of the file
+ *  - uint64_t* block_count: Set to the amount of blocks
+ *  - uint64_t* index_offset: Set to where the block index starts
+ * Return Value:
+ *  - DecodeBlock*: A block for every index entry with only the entry filled in, NULL if the index is damaged
+ */
+static DecodeBlock* readBlockIndex(const unsigned char* data, size_t size, uint64_t* block_count, uint64_t* index_offset) {
+  if (size < CONTAINER_HEADER_SIZE + 1 + CONTAINER_FOOTER_SIZE || memcmp(data + size - 4, CONTAINER_FOOTER_MAGIC, 4) != 0) {
+    fprintf(stderr, "The block index of the compressed file is missing\n");
+    return NULL;
+  }
+
+  const unsigned char* footer = data + size - CONTAINER_FOOTER_SIZE;
+  *index_offset = loadLittleEndian(footer, 8);
+  *block_count = loadLittleEndian(footer + 8, 4);
+
+  // the index sits between the end marker and the footer
+  size_t index_end = size - CONTAINER_FOOTER_SIZE;
+  if (*index_offset <= CONTAINER_HEADER_SIZE || *index_offset > index_end || data[*index_offset - 1] != BLOCK_TYPE_END
+      || (index_end - *index_offset) / BLOCK_INDEX_ENTRY_SIZE != *block_count || (index_end - *index_offset) % BLOCK_INDEX_ENTRY_SIZE != 0) {
+    fprintf(stderr, "The block index of the compressed file is damaged\n");
+    return NULL;
+  }
+
+  // one extra block so an empty file still gets an allocation
+  DecodeBlock* blocks = (DecodeBlock*) calloc((size_t) *block_count + 1, sizeof(DecodeBlock));
+  if (blocks == NULL) {
+    fprintf(stderr, "Failed to allocate memory for the block index\n");
+    return NULL;
+  }
+
+  for (uint64_t i = 0; i < *block_count; i++) {
+    const unsigned char* entry = data + *index_offset + i * BLOCK_INDEX_ENTRY_SIZE;
+    blocks[i].entry.offset = loadLittleEndian(entry, 8);
+    blocks[i].entry.bit_length = loadLittleEndian(entry + 8, 8);
+    blocks[i].entry.decoded_length = loadLittleEndian(entry + 16, 8);
+  }
+
+  return blocks;
+}
+
+/**
+ * Function Name: readContainer
+ * Purpose: Validates the header, the block index and the header of every block, and finds where the characters of
+ *  every block go in the output. A block that reuses a table needs to know which block has it, so this is done in order
+ * Parameters:
+ *  - const unsigned char* data: The contents of the compressed file
+ *  - size_t size: The size of the compressed file
+ *  - uint64_t* block_count: Set to the amount of blocks
+ *  - uint64_t* total_length: Set to the size of the decompressed output
+ * Return Value:
+ *  - DecodeBlock*: Every block, ready to be decoded, NULL if the file is damaged
+ */
+static DecodeBlock* readContainer(const unsigned char* data, size_t size, uint64_t* block_count, uint64_t* total_length) {
+  uint64_t index_offset;
+  DecodeBlock* blocks = NULL;
+  if (readContainerHeader(data, size) == -1 || (blocks = readBlockIndex(data, size, block_count, &index_offset)) == NULL) {
+    return NULL;
+  }
+
+  *total_length = 0;
+  for (uint64_t i = 0; i < *block_count; i++) {
+    DecodeBlock* block = &blocks[i];
+    if (readBlockHeader(data, size, (size_t) block->entry.offset, data[5], data[6], &block->header, block->lengths) == -1) {
+      free(blocks);
+      return NULL;
+    }
+
+    // the bitstream has to end before the end marker, peekBits reads up to 16 bytes past it.
+    // every code is at least one bit, so a block can not claim more characters than its bitstream has bits
+    if (block->header.block_type == BLOCK_TYPE_END || block->header.symbol_count != block->entry.decoded_length
+        || block->entry.bit_length > block->header.payload_size * 8 || block->header.payload_offset + block->header.payload_size >= index_offset
+        || block->entry.decoded_length > block->entry.bit_length || block->entry.decoded_length > SIZE_MAX - *total_length) {
+      fprintf(stderr, "The block index of the compressed file is damaged\n");
+      free(blocks);
+      return NULL;
+    }
+
+    if (block->header.block_type == BLOCK_TYPE_NEW_TABLE || block->header.block_type == BLOCK_TYPE_DICTIONARY) {
+      block->table_block = i;
+    } else if (i > 0) {
+      block->table_block = blocks[i - 1].table_block;
+    } else {
+      fprintf(stderr, "The first block has no code length table\n");
+      free(blocks);
+      return NULL;
+    }
+
+    block->output_offset = *total_length;
+    *total_length += block->entry.decoded_length;
+  }
+
+  return blocks;
+}
+
+/**
+ * Function Name: buildTableTask
+ * Purpose: Pool task, builds the decode table of a block that has a new table, unless the table cache had it
+ * Parameters:
+ *  - void* argument: The DecodeJob
+ *  - int index: The block
+ * Return Value:
+ *  - void
+ */
+static void buildTableTask(void* argument, int index) {
+  DecodeJob* job = (DecodeJob*) argument;
+  DecodeBlock* block = &job->blocks[index];
+
+  if (block->header.block_type != BLOCK_TYPE_NEW_TABLE || block->cache_entry != -1) {
+    return;
+  }
+  uint64_t lap = 0;
+  statsLap(job->timed, &lap);
+  size_t subtables_capacity = block->table->subtables_capacity;
+
+  // the alphabet is a constant in each branch, like in analyzeBlockTask
+  int result = job->mode == HUFFMAN_MODE_RAW ? buildDecodeTable(block->table, block->lengths, &RAW_ALPHABET) :
+                                               buildDecodeTable(block->table, block->lengths, &TEXT_ALPHABET);
+  block->allocations += block->table->subtables_capacity != subtables_capacity;
+  block->table_nanoseconds += statsLap(job->timed, &lap);
+
+  // a table that could not be built is dropped, the blocks decoded with it fail
+  if (result == -1) {
+    block->table = NULL;
+  }
+}
+
+/**
+ * Function Name: decodeBlockTask
+ * Purpose: Pool task, decodes a block into its slice of the output
+ * Parameters:
+ *  - void* argument: The DecodeJob
+ *  - int index: The block
+ * Return Value:
+ *  - void
+ */
+static void decodeBlockTask(void* argument, int index) {
+  DecodeJob* job = (DecodeJob*) argument;
+  DecodeBlock* block = &job->blocks[index];
+  const DecodeBlock* table_block = &job->blocks[block->table_block];
+  block->result = -1;
+  uint64_t lap = 0;
+  statsLap(job->timed, &lap);
+
+  if (table_block->table == NULL) {
+    return;
+  }
+
+  // every character takes at least one code of the shortest length
+  int shortest = 64;
+  for (int c = 0; c < 256; c++) {
+    if (table_block->lengths[c] != 0 && table_block->lengths[c] < shortest) {
+      shortest = table_block->lengths[c];
+    }
+  }
+  if (shortest == 64 || block->entry.decoded_length > block->entry.bit_length / (uint64_t) shortest) {
+    return;
+  }
+
+  uint64_t decoded;
+  if (block->header.stream_count == 1) {
+    decoded = decodeSymbols(table_block->table, job->data + block->header.payload_offset, block->entry.bit_length, 0,
+      job->output + block->output_offset, block->entry.decoded_length);
+  } else {
+    decoded = decodeStreams(table_block->table, job->data + block->header.payload_offset, &block->header, job->output + block->output_offset);
+  }
+  if (decoded == block->entry.decoded_length) {
+    block->result = 1;
+  }
+  block->decode_nanoseconds += statsLap(job->timed, &lap);
+}
+
+/**
+ * Function Name: reserveDecodeTables
+ * Purpose: Makes sure the decoder has at least table_count decode tables, the tables it already has are kept
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder
+ *  - uint64_t table_count: The amount of tables needed
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+static int reserveDecodeTables(HuffmanDecoder* decoder, uint64_t table_count) {
+  if (table_count <= decoder->table_capacity) {
+    return 1;
+  }
+
+  DecodeTable* tables = (DecodeTable*) realloc(decoder->tables, table_count * sizeof(DecodeTable));
+  if (tables == NULL) {
+    return -1;
+  }
+
+  // the new tables have no subtables yet
+  memset(tables + decoder->table_capacity, 0, (table_count - decoder->table_capacity) * sizeof(DecodeTable));
+  decoder->tables = tables;
+  decoder->table_capacity = table_count;
+  return 1;
+}
+
+/**
+ * Function Name: findDecodeTable
+ * Purpose: Looks up a decode table built for an earlier input from the same code lengths
+ * Parameters:
+ *  - const HuffmanDecoder* decoder: The decoder
+ *  - int mode: The mode of the container, it decides the alphabet of the table
+ *  - const uint8_t lengths[]: The code length of every character
+ * Return Value:
+ *  - int: the table cache entry, -1 if no table has these lengths
+ */
+static int findDecodeTable(const HuffmanDecoder* decoder, int mode, const uint8_t lengths[]) {
+  if (decoder->table_cache == NULL) {
+    return -1;
+  }
+
+  for (int i = 0; i < TABLE_CACHE_SIZE; i++) {
+    const DecodeCacheEntry* entry = &decoder->table_cache[i];
+    if (entry->last_use != 0 && entry->mode == mode && memcmp(entry->lengths, lengths, sizeof(entry->lengths)) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Function Name: cacheDecodeTables
+ * Purpose: Moves the first tables an input built into the table cache, replacing an empty entry or the entry used
+ *  longest ago. The replaced table goes to the decoder tables in exchange, so no table is copied or allocated again
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder
+ *  - DecodeBlock* blocks: The decoded blocks, their tables still set
+ *  - uint64_t block_count: The amount of blocks
+ *  - int mode: The mode of the container
+ * Return Value:
+ *  - void
+ */
+static void cacheDecodeTables(HuffmanDecoder* decoder, DecodeBlock* blocks, uint64_t block_count, int mode) {
+  int cached = 0;
+  for (uint64_t i = 0; i < block_count && cached < TABLE_CACHE_SIZE; i++) {
+    DecodeBlock* block = &blocks[i];
+    if (block->header.block_type != BLOCK_TYPE_NEW_TABLE || block->cache_entry != -1 || block->table == NULL
+        || findDecodeTable(decoder, mode, block->lengths) != -1) {
+      continue;
+    }
+
+    if (decoder->table_cache == NULL) {
+      decoder->table_cache = (DecodeCacheEntry*) calloc(TABLE_CACHE_SIZE, sizeof(DecodeCacheEntry));
+      decoder->stats.allocations += 1;
+      if (decoder->table_cache == NULL) {
+        return;
+      }
+    }
+
+    int entry = 0;
+    for (int j = 1; j < TABLE_CACHE_SIZE; j++) {
+      if (decoder->table_cache[j].last_use < decoder->table_cache[entry].last_use) {
+        entry = j;
+      }
+    }
+
+    DecodeCacheEntry* cache_entry = &decoder->table_cache[entry];
+    DecodeTable replaced = cache_entry->table;
+    cache_entry->table = *block->table;
+    *block->table = replaced;
+    cache_entry->mode = mode;
+    memcpy(cache_entry->lengths, block->lengths, sizeof(cache_entry->lengths));
+    cache_entry->last_use = ++decoder->table_cache_clock;
+    cached += 1;
+  }
+}
+
+/**
+ * Function Name: decodeContainer
+ * Purpose: Builds the tables and decodes the blocks on the thread pool, every block straight into its slice of the output.
+ *  Tables the decoder built for an earlier input from the same code lengths are taken from its table cache
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder whose thread pool and tables are used
+ *  - const unsigned char* data: The contents of the compressed file
+ *  - DecodeBlock* blocks: The blocks from readContainer
+ *  - uint64_t block_count: The amount of blocks
+ *  - unsigned char* output: Room for the whole decompressed output
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+static int decodeContainer(HuffmanDecoder* decoder, const unsigned char* data, DecodeBlock* blocks, uint64_t block_count, unsigned char* output) {
+  // a table an earlier input built from the same code lengths is not built again
+  uint64_t new_table_count = 0;
+  uint64_t table_count = 0;
+  for (uint64_t i = 0; i < block_count; i++) {
+    if (blocks[i].header.block_type == BLOCK_TYPE_NEW_TABLE) {
+      blocks[i].cache_entry = findDecodeTable(decoder, data[5], blocks[i].lengths);
+      new_table_count += 1;
+      table_count += blocks[i].cache_entry == -1;
+    }
+  }
+
+  size_t table_capacity = decoder->table_capacity;
+  if (block_count > INT32_MAX || threadPoolReserve(decoder->pool, (int) block_count) == -1 ||
+      reserveDecodeTables(decoder, table_count) == -1) {
+    fprintf(stderr, "Failed to allocate memory for content\n");
+    return -1;
+  }
+
+  // the tables of the decoder are handed out in block order, the dictionary table is already built
+  uint64_t table_index = 0;
+  for (uint64_t i = 0; i < block_count; i++) {
+    if (blocks[i].header.block_type == BLOCK_TYPE_NEW_TABLE && blocks[i].cache_entry != -1) {
+      blocks[i].table = &decoder->table_cache[blocks[i].cache_entry].table;
+      decoder->table_cache[blocks[i].cache_entry].last_use = ++decoder->table_cache_clock;
+    } else if (blocks[i].header.block_type == BLOCK_TYPE_NEW_TABLE) {
+      blocks[i].table = &decoder->tables[table_index++];
+    } else if (blocks[i].header.block_type == BLOCK_TYPE_DICTIONARY) {
+      if (!decoder->has_dictionary || decoder->dictionary.id != blocks[i].header.dictionary_id || decoder->dictionary.mode != data[5]) {
+        fprintf(stderr, "The compressed data needs dictionary %u\n", (unsigned) blocks[i].header.dictionary_id);
+        return -1;
+      }
+      blocks[i].table = &decoder->dictionary_table;
+      memcpy(blocks[i].lengths, decoder->dictionary.lengths, sizeof(blocks[i].lengths));
+    }
+  }
+
+  ThreadPool* pool = decoder->pool;
+
+  DecodeJob job = { data, blocks, output, data[5], decoder->stats_enabled };
+  threadPoolRun(pool, buildTableTask, &job, (int) block_count);
+  threadPoolRun(pool, decodeBlockTask, &job, (int) block_count);
+
+  HuffmanStats* stats = &decoder->stats;
+  stats->blocks += block_count;
+  stats->new_tables += new_table_count;
+  stats->cached_tables += new_table_count - table_count;
+  stats->allocations += decoder->table_capacity != table_capacity;
+  cacheDecodeTables(decoder, blocks, block_count, data[5]);
+
+  int result = 1;
+  for (uint64_t i = 0; i < block_count; i++) {
+    if (blocks[i].result == -1 && result == 1) {
+      fprintf(stderr, "The compressed data of block %llu is damaged\n", (unsigned long long) i);
+      result = -1;
+    }
+    blocks[i].table = NULL;
+
+    stats->nanoseconds[HUFFMAN_STAGE_TABLE] += blocks[i].table_nanoseconds;
+    stats->nanoseconds[HUFFMAN_STAGE_DECODE] += blocks[i].decode_nanoseconds;
+    stats->allocations += blocks[i].allocations;
+    stats->symbols += blocks[i].entry.decoded_length;
+  }
+
+  return result;
+}
+
+// DICTIONARIES
+static int checkDictionary(const HuffmanDictionary* dictionary);
+static uint32_t dictionaryFingerprint(const HuffmanDictionary* dictionary);
+
+/**
+ * Function Name: checkDictionary
+ * Purpose: Makes sure a dictionary can encode any input of its mode, every character of the alphabet needs a code
+ *  no longer than MAX_MAX_CODE_LENGTH and the codes have to form a prefix code
+ * Parameters:
+ *  - const HuffmanDictionary* dictionary: The dictionary
+ * Return Value:
+ *  - int: -1 if the dictionary is invalid and 1 if successful
+ */
+static int checkDictionary(const HuffmanDictionary* dictionary) {
+  if (dictionary->mode != HUFFMAN_MODE_TEXT && dictionary->mode != HUFFMAN_MODE_RAW) {
+    fprintf(stderr, "Unsupported dictionary mode %d\n", dictionary->mode);
+    return -1;
+  }
+
+  const Alphabet* alphabet = modeAlphabet(dictionary->mode);
+  int code_count = 0;
+  for (int c = 0; c < 256; c++) {
+    code_count += dictionary->lengths[c] != 0;
+  }
+  for (int i = 0; i < alphabet->size; i++) {
+    uint8_t length = dictionary->lengths[alphabet->characters[i]];
+    if (length == 0 || length > MAX_MAX_CODE_LENGTH) {
+      code_count = -1;
+      break;
+    }
+  }
+
+  // a text dictionary can not have codes for characters the text mode never encodes
+  DecodeCode codes[256];
+  if (code_count != alphabet->size || assignDecodeCodes(dictionary->lengths, alphabet, codes) == -1) {
+    fprintf(stderr, "The dictionary does not have a valid code for every character\n");
+    return -1;
+  }
+
+  return 1;
+}
+
+/**
+ * Function Name: dictionaryFingerprint
+ * Purpose: Hashes the mode and code lengths of a dictionary with FNV-1a, the id of a dictionary trained without one
+ * Parameters:
+ *  - const HuffmanDictionary* dictionary: The dictionary
+ * Return Value:
+ *  - uint32_t: the hash, never 0
+ */
+static uint32_t dictionaryFingerprint(const HuffmanDictionary* dictionary) {
+  uint32_t hash = 2166136261u;
+  hash = (hash ^ (uint32_t) dictionary->mode) * 16777619u;
+  for (int c = 0; c < 256; c++) {
+    hash = (hash ^ dictionary->lengths[c]) * 16777619u;
+  }
+  return hash != 0 ? hash : 1;
+}
+
+// PUBLIC INTERFACE
+// the functions declared in huffman.h, everything above is internal to the library
+
+/**
+ * Function Name: createHuffmanEncoder
+ * Purpose: Creates the thread pool and block buffers of an encoder, so a batch of inputs only creates them once
+ * Parameters:
+ *  - size_t block_size: The amount of input bytes in a block, 0 for HUFFMAN_BLOCK_SIZE or the default
+ *  - int thread_count: The amount of threads to use, 0 for HUFFMAN_THREADS or one per core
+ * Return Value:
+ *  - HuffmanEncoder*: The encoder, NULL if it could not be allocated
+ */
+HuffmanEncoder* createHuffmanEncoder(size_t block_size, int thread_count) {
+  if (block_size == 0) {
+    block_size = getBlockSize();
+  } else if (block_size < MIN_BLOCK_SIZE) {
+    block_size = MIN_BLOCK_SIZE;
+  } else if (block_size > MAX_BLOCK_SIZE) {
+    block_size = MAX_BLOCK_SIZE;
+  }
+
+  if (thread_count <= 0) {
+    thread_count = getThreadCount();
+  }
+
+  HuffmanEncoder* encoder = (HuffmanEncoder*) calloc(1, sizeof(HuffmanEncoder));
+  if (encoder == NULL) {
+    fprintf(stderr, "An error has occured while allocating memory.\n");
+    return NULL;
+  }
+
+  // two blocks per thread give the stealing something to balance
+  encoder->block_size = block_size;
+  encoder->thread_count = thread_count;
+  encoder->max_code_length = getMaxCodeLength();
+  encoder->stream_count = getStreamCount();
+  encoder->table_cache_margin = getTableCacheMargin();
+  encoder->batch_capacity = thread_count * 2;
+  encoder->pool = createThreadPool(thread_count, encoder->batch_capacity);
+  encoder->jobs = createBlockJobs(encoder->batch_capacity, block_size);
+  if (encoder->pool == NULL || encoder->jobs == NULL) {
+    fprintf(stderr, "An error has occured while allocating memory.\n");
+    freeHuffmanEncoder(encoder);
+    return NULL;
+  }
+
+  return encoder;
+}
+
+/**
+ * Function Name: freeHuffmanEncoder
+ * Purpose: Stops the thread pool and frees the block buffers
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder, may be NULL
+ * Return Value:
+ *  - void
+ */
+void freeHuffmanEncoder(HuffmanEncoder* encoder) {
+  if (encoder == NULL) {
+    return;
+  }
+
+  freeBlockJobs(encoder->jobs, encoder->batch_capacity);
+  freeThreadPool(encoder->pool);
+  free(encoder);
+}
+
+/**
+ * Function Name: huffmanSetMaxCodeLength
+ * Purpose: Sets the longest code the encoder may give a character. Shorter limits keep the decode tables small
+ *  at the cost of a little compression on skewed inputs.
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - int max_code_length: The maximum code length in bits, from MIN_MAX_CODE_LENGTH to MAX_MAX_CODE_LENGTH
+ * Return Value:
+ *  - int: -1 if the length is out of range and 1 if successful
+ */
+int huffmanSetMaxCodeLength(HuffmanEncoder* encoder, int max_code_length) {
+  if (max_code_length < MIN_MAX_CODE_LENGTH || max_code_length > MAX_MAX_CODE_LENGTH) {
+    fprintf(stderr, "The maximum code length must be between %d and %d bits\n", MIN_MAX_CODE_LENGTH, MAX_MAX_CODE_LENGTH);
+    return -1;
+  }
+
+  encoder->max_code_length = max_code_length;
+  return 1;
+}
+
+/**
+ * Function Name: huffmanSetMode
+ * Purpose: Sets how the encoder treats its input. The text mode keeps the encodable characters only, case folded and
+ *  with whitespace turned into spaces. The raw mode skips all of that and compresses every byte, so any input comes
+ *  back exactly as it was. The mode is stored in the compressed data, the decoder does not need to know it.
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - int mode: HUFFMAN_MODE_TEXT or HUFFMAN_MODE_RAW
+ * Return Value:
+ *  - int: -1 if the mode is unknown and 1 if successful
+ */
+int huffmanSetMode(HuffmanEncoder* encoder, int mode) {
+  if (mode != HUFFMAN_MODE_TEXT && mode != HUFFMAN_MODE_RAW) {
+    fprintf(stderr, "Unknown mode %d\n", mode);
+    return -1;
+  }
+
+  if (encoder->has_dictionary && encoder->dictionary.mode != mode) {
+    fprintf(stderr, "The mode of the encoder has to stay the mode of its dictionary\n");
+    return -1;
+  }
+
+  encoder->mode = mode;
+  return 1;
+}
+
+/**
+ * Function Name: huffmanSetStreamCount
+ * Purpose: Sets how many streams every block is split into. The decoder follows the streams of a block side by side,
+ *  so the table lookups of one stream do not wait for the codes of the other streams to be decoded.
+ *  Every extra stream costs its size in the block header and the padding of its last byte.
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - int stream_count: The amount of streams, from 1 to HUFFMAN_MAX_STREAMS
+ * Return Value:
+ *  - int: -1 if the amount is out of range and 1 if successful
+ */
+int huffmanSetStreamCount(HuffmanEncoder* encoder, int stream_count) {
+  if (stream_count < 1 || stream_count > HUFFMAN_MAX_STREAMS) {
+    fprintf(stderr, "The amount of streams must be between 1 and %d\n", HUFFMAN_MAX_STREAMS);
+    return -1;
+  }
+
+  encoder->stream_count = stream_count;
+  return 1;
+}
+
+/**
+ * Function Name: huffmanSetTableCache
+ * Purpose: Turns the table cache of the encoder on or off. With the cache on a block whose histogram has the shape of
+ *  one an earlier input built a table for takes that table instead of building one, when it costs at most margin percent
+ *  more bits than the entropy of the block. Turning the cache off empties it
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - int margin: The margin in percent, from 0 to MAX_TABLE_CACHE_MARGIN, or -1 to turn the cache off
+ * Return Value:
+ *  - int: -1 if the margin is out of range and 1 if successful
+ */
+int huffmanSetTableCache(HuffmanEncoder* encoder, int margin) {
+  if (margin < TABLE_CACHE_OFF || margin > MAX_TABLE_CACHE_MARGIN) {
+    fprintf(stderr, "The table cache margin must be between 0 and %d percent, or -1 to turn the cache off\n", MAX_TABLE_CACHE_MARGIN);
+    return -1;
+  }
+
+  if (margin == TABLE_CACHE_OFF) {
+    memset(encoder->table_cache, 0, sizeof(encoder->table_cache));
+  }
+  encoder->table_cache_margin = margin;
+  return 1;
+}
+
+/**
+ * Function Name: huffmanEncodeBound
+ * Purpose: Gets the largest size the compressed output of an input can have, every character taking the longest possible code
+ * Parameters:
+ *  - const HuffmanEncoder* encoder: The encoder that compresses the input
+ *  - size_t input_size: The amount of input bytes
+ * Return Value:
+ *  - size_t: the size in bytes
+ */
+size_t huffmanEncodeBound(const HuffmanEncoder* encoder, size_t input_size) {
+  size_t block_count = input_size / encoder->block_size + (input_size % encoder->block_size != 0);
+  int alphabet_size = encoder->mode == HUFFMAN_MODE_RAW ? 256 : (int) ENCODABLE_CHARACTER_COUNT;
+  size_t max_length = (size_t) longestCodeLength(encoder->block_size, alphabet_size, encoder->max_code_length);
+  for (int c = 0; encoder->has_dictionary && c < 256; c++) {
+    if (encoder->dictionary.lengths[c] > max_length) {
+      max_length = encoder->dictionary.lengths[c];
+    }
+  }
+
+  // every stream of every block is padded to a whole byte
+  size_t payload_size = input_size / 8 * max_length + (input_size % 8 * max_length + 7) / 8 + block_count * (size_t) encoder->stream_count;
+  return CONTAINER_HEADER_SIZE + payload_size + block_count * (BLOCK_HEADER_MAX_SIZE + BLOCK_INDEX_ENTRY_SIZE) + 1 + CONTAINER_FOOTER_SIZE;
+}
+
+/**
+ * Function Name: huffmanEncodeBuffer
+ * Purpose: Compresses a buffer into a buffer, nothing is read from or written to a file
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - const unsigned char* input: The bytes to compress
+ *  - size_t input_size: The amount of bytes in input
+ *  - unsigned char* output: Where the compressed data is written
+ *  - size_t output_capacity: The size of output, huffmanEncodeBound is always enough
+ *  - size_t* output_size: Set to the size of the compressed data
+ * Return Value:
+ *  - int: -1 if failed, also when output is too small, and 1 if successful
+ */
+int huffmanEncodeBuffer(HuffmanEncoder* encoder, const unsigned char* input, size_t input_size, unsigned char* output, size_t output_capacity, size_t* output_size) {
+  uint64_t lap = 0;
+  statsLap(encoder->stats_enabled, &lap);
+
+  InputFile source;
+  openInputBuffer(&source, input, input_size);
+
+  OutputSink sink = { NULL, output, output_capacity, 0, 0 };
+  int result = encodeContainer(encoder, &source, &sink);
+  *output_size = sink.size;
+  encoder->stats.nanoseconds[HUFFMAN_STAGE_TOTAL] += statsLap(encoder->stats_enabled, &lap);
+  return result;
+}
+
+/**
+ * Function Name: huffmanEncodeFile
+ * Purpose: Compresses a file into a stream, memory use only depends on the block size and the amount of threads
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - const char* input_name: The file to compress, "-" for stdin
+ *  - FILE* output: The opened output file, it does not need to be seekable
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+int huffmanEncodeFile(HuffmanEncoder* encoder, const char* input_name, FILE* output) {
+  uint64_t start = 0;
+  uint64_t lap = 0;
+  statsLap(encoder->stats_enabled, &start);
+  statsLap(encoder->stats_enabled, &lap);
+
+  InputFile input;
+  if (openInputFile(&input, input_name) == -1) {
+    fprintf(stderr, "File: '%s' could not be opened\n", input_name);
+    return -1;
+  }
+  encoder->stats.nanoseconds[HUFFMAN_STAGE_READ] += statsLap(encoder->stats_enabled, &lap);
+
+  OutputSink sink = { output, NULL, 0, 0, 0 };
+  int result = encodeContainer(encoder, &input, &sink);
+  statsLap(encoder->stats_enabled, &lap);
+  closeInputFile(&input);
+  encoder->stats.nanoseconds[HUFFMAN_STAGE_READ] += statsLap(encoder->stats_enabled, &lap);
+  encoder->stats.nanoseconds[HUFFMAN_STAGE_TOTAL] += statsLap(encoder->stats_enabled, &start);
+  return result;
+}
+
+/**
+ * Function Name: huffmanEncoderCounts
+ * Purpose: Gets the frequency of every character in the input that was compressed last
+ * Parameters:
+ *  - const HuffmanEncoder* encoder: The encoder
+ * Return Value:
+ *  - const uint64_t*: 256 counts indexed by byte value
+ */
+const uint64_t* huffmanEncoderCounts(const HuffmanEncoder* encoder) {
+  return encoder->histogram.counts;
+}
+
+/**
+ * Function Name: huffmanBuildCodes
+ * Purpose: Builds the canonical huffman codes for a frequency table from a huffman tree, limited to the maximum code length of the encoder
+ * Parameters:
+ *  - const HuffmanEncoder* encoder: The encoder whose maximum code length is used
+ *  - const uint64_t counts[]: The frequency of every character, 256 counts indexed by byte value
+ *  - uint64_t codes[]: Set to the code word of every character, right aligned
+ *  - uint8_t lengths[]: Set to the bit length of every code word, 0 if the character has no code
+ * Return Value:
+ *  - int: -1 if the huffman tree could not be built and 1 if successful
+ */
+int huffmanBuildCodes(const HuffmanEncoder* encoder, const uint64_t counts[], uint64_t codes[], uint8_t lengths[]) {
+  Histogram histogram;
+  memcpy(histogram.counts, counts, sizeof(histogram.counts));
+
+  // the codes of the whole file come from the min heap huffman tree, the blocks use the faster sorted builder
+  NodeArena arena;
+  MinHeapNode* root;
+  if (buildHuffmanTree(&histogram, &arena, &root) == -1) {
+    return -1;
+  }
+  uint8_t tree_lengths[256] = { 0 };
+  if (root != NULL) {
+    computeCodeLengths(root, 0, tree_lengths);
+  }
+
+  EncoderTable table;
+  // any byte may occur in the counts of the caller, so the generic alphabet is used
+  finishEncoderTable(&histogram, &RAW_ALPHABET, encoder->max_code_length, tree_lengths, &table);
+  memcpy(codes, table.codes, sizeof(table.codes));
+  memcpy(lengths, table.lengths, sizeof(table.lengths));
+  return 1;
+}
+
+/**
+ * Function Name: huffmanEncoderSetDictionary
+ * Purpose: Encodes every block with the table of a dictionary, so the blocks are not counted, no table is built and
+ *  none is stored. This pays off for inputs too small to carry a table of their own. The encoder takes the mode of the dictionary
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - const HuffmanDictionary* dictionary: The dictionary, copied into the encoder, NULL to build a table for every block again
+ * Return Value:
+ *  - int: -1 if the dictionary is invalid and 1 if successful
+ */
+int huffmanEncoderSetDictionary(HuffmanEncoder* encoder, const HuffmanDictionary* dictionary) {
+  if (dictionary == NULL) {
+    encoder->has_dictionary = 0;
+    return 1;
+  }
+
+  if (checkDictionary(dictionary) == -1) {
+    return -1;
+  }
+
+  encoder->dictionary = *dictionary;
+  encoder->mode = dictionary->mode;
+  assignCanonicalCodes(dictionary->lengths, modeAlphabet(dictionary->mode), &encoder->dictionary_table);
+  encoder->has_dictionary = 1;
+  return 1;
+}
+
+/**
+ * Function Name: huffmanEncoderSetStats
+ * Purpose: Turns the statistics of an encoder on or off, turning them on clears them
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ *  - int enabled: 1 to time the stages and count, 0 to not read the clock at all
+ * Return Value:
+ *  - void
+ */
+void huffmanEncoderSetStats(HuffmanEncoder* encoder, int enabled) {
+  if (enabled && !encoder->stats_enabled) {
+    memset(&encoder->stats, 0, sizeof(HuffmanStats));
+  }
+  encoder->stats_enabled = enabled != 0;
+}
+
+/**
+ * Function Name: huffmanEncoderStats
+ * Purpose: Gets the statistics of an encoder, the caller may add the stages it times itself
+ * Parameters:
+ *  - HuffmanEncoder* encoder: The encoder
+ * Return Value:
+ *  - HuffmanStats*: the statistics of every input since they were turned on
+ */
+HuffmanStats* huffmanEncoderStats(HuffmanEncoder* encoder) {
+  return &encoder->stats;
+}
+
+/**
+ * Function Name: createHuffmanDecoder
+ * Purpose: Creates the thread pool of a decoder, so a batch of inputs only creates it once
+ * Parameters:
+ *  - int thread_count: The amount of threads to use, 0 for HUFFMAN_THREADS or one per core
+ * Return Value:
+ *  - HuffmanDecoder*: The decoder, NULL if it could not be allocated
+ */
+HuffmanDecoder* createHuffmanDecoder(int thread_count) {
+  if (thread_count <= 0) {
+    thread_count = getThreadCount();
+  }
+
+  HuffmanDecoder* decoder = (HuffmanDecoder*) calloc(1, sizeof(HuffmanDecoder));
+  if (decoder == NULL || (decoder->pool = createThreadPool(thread_count, thread_count)) == NULL) {
+    fprintf(stderr, "Failed to allocate memory for the thread pool\n");
+    free(decoder);
+    return NULL;
+  }
+
+  return decoder;
+}
+
+/**
+ * Function Name: freeHuffmanDecoder
+ * Purpose: Stops the thread pool and frees the decoder and its decode tables
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder, may be NULL
+ * Return Value:
+ *  - void
+ */
+void freeHuffmanDecoder(HuffmanDecoder* decoder) {
+  if (decoder == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < decoder->table_capacity; i++) {
+    freeDecodeTable(&decoder->tables[i]);
+  }
+  free(decoder->tables);
+  freeDecodeTable(&decoder->dictionary_table);
+  for (int i = 0; decoder->table_cache != NULL && i < TABLE_CACHE_SIZE; i++) {
+    freeDecodeTable(&decoder->table_cache[i].table);
+  }
+  free(decoder->table_cache);
+  freeThreadPool(decoder->pool);
+  free(decoder);
+}
+
+/**
+ * Function Name: huffmanDecodedSize
+ * Purpose: Validates compressed data and gets the exact size of the decompressed output from its block index
+ * Parameters:
+ *  - const unsigned char* input: The compressed data
+ *  - size_t input_size: The size of the compressed data
+ *  - size_t* decoded_size: Set to the size of the decompressed output
+ * Return Value:
+ *  - int: -1 if the data is damaged and 1 if successful
+ */
+int huffmanDecodedSize(const unsigned char* input, size_t input_size, size_t* decoded_size) {
+  uint64_t block_count;
+  uint64_t total_length;
+  DecodeBlock* blocks = readContainer(input, input_size, &block_count, &total_length);
+  if (blocks == NULL) {
+    return -1;
+  }
+
+  free(blocks);
+  *decoded_size = (size_t) total_length;
+  return 1;
+}
+
+/**
+ * Function Name: huffmanDecodeBuffer
+ * Purpose: Decompresses a buffer into a buffer, nothing is read from or written to a file
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder
+ *  - const unsigned char* input: The compressed data
+ *  - size_t input_size: The size of the compressed data
+ *  - unsigned char* output: Where the decompressed output is written
+ *  - size_t output_capacity: The size of output, huffmanDecodedSize gives the size that is needed
+ *  - size_t* output_size: Set to the size of the decompressed output
+ * Return Value:
+ *  - int: -1 if failed, also when output is too small, and 1 if successful
+ */
+int huffmanDecodeBuffer(HuffmanDecoder* decoder, const unsigned char* input, size_t input_size, unsigned char* output, size_t output_capacity, size_t* output_size) {
+  HuffmanStats* stats = &decoder->stats;
+  uint64_t start = 0;
+  uint64_t lap = 0;
+  statsLap(decoder->stats_enabled, &start);
+  statsLap(decoder->stats_enabled, &lap);
+
+  uint64_t block_count;
+  uint64_t total_length;
+  DecodeBlock* blocks = readContainer(input, input_size, &block_count, &total_length);
+  if (blocks == NULL) {
+    return -1;
+  }
+  stats->nanoseconds[HUFFMAN_STAGE_PARSE] += statsLap(decoder->stats_enabled, &lap);
+
+  if (total_length > output_capacity) {
+    fprintf(stderr, "The output buffer is too small for the decompressed data\n");
+    free(blocks);
+    return -1;
+  }
+
+  int result = decodeContainer(decoder, input, blocks, block_count, output);
+  free(blocks);
+  *output_size = (size_t) total_length;
+
+  stats->inputs += 1;
+  stats->input_bytes += input_size;
+  stats->output_bytes += total_length;
+  stats->allocations += 1;
+  stats->nanoseconds[HUFFMAN_STAGE_TOTAL] += statsLap(decoder->stats_enabled, &start);
+  return result;
+}
+
+/**
+ * Function Name: huffmanDecodeFile
+ * Purpose: Decompresses a file, everything needed is in the file itself.
+ *  The blocks are found through the block index and decoded in parallel, straight from the mapped input
+ *  into the mapped output.
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder
+ *  - const char* input_name: The compressed file, "-" for stdin
+ *  - const char* output_name: The decompressed file, "-" for stdout, it is overwritten if it exists
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+int huffmanDecodeFile(HuffmanDecoder* decoder, const char* input_name, const char* output_name) {
+  HuffmanStats* stats = &decoder->stats;
+  uint64_t start = 0;
+  uint64_t lap = 0;
+  statsLap(decoder->stats_enabled, &start);
+  statsLap(decoder->stats_enabled, &lap);
+
+  MappedFile input;
+  if (mapInputFile(input_name, &input) == -1) {
+    return -1;
+  }
+  stats->nanoseconds[HUFFMAN_STAGE_READ] += statsLap(decoder->stats_enabled, &lap);
+
+  uint64_t block_count;
+  uint64_t total_length;
+  DecodeBlock* blocks = readContainer(input.data, input.size, &block_count, &total_length);
+  if (blocks == NULL) {
+    closeMappedFile(&input);
+    return -1;
+  }
+  stats->nanoseconds[HUFFMAN_STAGE_PARSE] += statsLap(decoder->stats_enabled, &lap);
+
+  MappedFile output;
+  if (mapOutputFile(output_name, (size_t) total_length, &output) == -1) {
+    free(blocks);
+    closeMappedFile(&input);
+    return -1;
+  }
+  stats->nanoseconds[HUFFMAN_STAGE_WRITE] += statsLap(decoder->stats_enabled, &lap);
+
+  int result = decodeContainer(decoder, input.data, blocks, block_count, output.data);
+  free(blocks);
+  stats->inputs += 1;
+  stats->input_bytes += input.size;
+  stats->output_bytes += total_length;
+  stats->allocations += 1;
+
+  statsLap(decoder->stats_enabled, &lap);
+  closeMappedFile(&input);
+  stats->nanoseconds[HUFFMAN_STAGE_READ] += statsLap(decoder->stats_enabled, &lap);
+
+  if (result == -1) {
+    // a mapped output already has its final size, do not leave it behind half decoded
+    int mapped = output.mapped;
+    closeMappedFile(&output);
+    if (mapped) {
+      remove(output_name);
+    }
+    return -1;
+  }
+
+  result = closeOutputFile(output_name, &output);
+  stats->nanoseconds[HUFFMAN_STAGE_WRITE] += statsLap(decoder->stats_enabled, &lap);
+  stats->nanoseconds[HUFFMAN_STAGE_TOTAL] += statsLap(decoder->stats_enabled, &start);
+  return result;
+}
+
+/**
+ * Function Name: huffmanDecoderSetDictionary
+ * Purpose: Gives the decoder the dictionary that blocks with its id were encoded with, its decode table is built once here
+ *  instead of for every input
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder
+ *  - const HuffmanDictionary* dictionary: The dictionary, copied into the decoder, NULL to remove it
+ * Return Value:
+ *  - int: -1 if the dictionary is invalid and 1 if successful
+ */
+int huffmanDecoderSetDictionary(HuffmanDecoder* decoder, const HuffmanDictionary* dictionary) {
+  decoder->has_dictionary = 0;
+  if (dictionary == NULL) {
+    return 1;
+  }
+
+  if (checkDictionary(dictionary) == -1 || buildDecodeTable(&decoder->dictionary_table, dictionary->lengths, modeAlphabet(dictionary->mode)) == -1) {
+    return -1;
+  }
+
+  decoder->dictionary = *dictionary;
+  decoder->has_dictionary = 1;
+  return 1;
+}
+
+/**
+ * Function Name: huffmanDecoderSetStats
+ * Purpose: Turns the statistics of a decoder on or off, turning them on clears them
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder
+ *  - int enabled: 1 to time the stages and count, 0 to not read the clock at all
+ * Return Value:
+ *  - void
+ */
+void huffmanDecoderSetStats(HuffmanDecoder* decoder, int enabled) {
+  if (enabled && !decoder->stats_enabled) {
+    memset(&decoder->stats, 0, sizeof(HuffmanStats));
+  }
+  decoder->stats_enabled = enabled != 0;
+}
+
+/**
+ * Function Name: huffmanDecoderStats
+ * Purpose: Gets the statistics of a decoder
+ * Parameters:
+ *  - HuffmanDecoder* decoder: The decoder
+ * Return Value:
+ *  - HuffmanStats*: the statistics of every input since they were turned on
+ */
+HuffmanStats* huffmanDecoderStats(HuffmanDecoder* decoder) {
+  return &decoder->stats;
+}
+
+/**
+ * Function Name: huffmanTrainDictionary
+ * Purpose: Counts the characters of sample files and builds a dictionary from them. Every character of the alphabet
+ *  gets one count more than it has, so characters the samples do not have still get a (long) code
+ * Parameters:
+ *  - const HuffmanEncoder* encoder: The encoder whose mode, maximum code length and block size are used
+ *  - const char* const sample_names[]: The sample files
+ *  - int sample_count: The amount of sample files
+ *  - uint32_t id: The id of the dictionary, 0 to derive it from the code lengths
+ *  - HuffmanDictionary* dictionary: Set to the trained dictionary
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+int huffmanTrainDictionary(const HuffmanEncoder* encoder, const char* const sample_names[], int sample_count, uint32_t id, HuffmanDictionary* dictionary) {
+  unsigned char* buffer = (unsigned char*) malloc(encoder->block_size);
+  if (buffer == NULL) {
+    fprintf(stderr, "An error has occured while allocating memory.\n");
+    return -1;
+  }
+
+  Histogram histogram;
+  memset(&histogram, 0, sizeof(Histogram));
+  int result = 1;
+  for (int i = 0; i < sample_count && result == 1; i++) {
+    InputFile input;
+    if (openInputFile(&input, sample_names[i]) == -1) {
+      fprintf(stderr, "File: '%s' could not be opened\n", sample_names[i]);
+      result = -1;
+      break;
+    }
+
+    // the samples are normalized like the inputs the dictionary is used for
+    const unsigned char* block;
+    size_t bytes_read;
+    while ((bytes_read = readInputBlock(&input, buffer, encoder->block_size, &block)) != 0) {
+      if (encoder->mode == HUFFMAN_MODE_RAW) {
+        histogramCount(&histogram, block, bytes_read);
+      } else {
+        histogramCount(&histogram, buffer, normalizeBytes(block, bytes_read, buffer));
+      }
+      releaseInput(&input);
+    }
+
+    if (input.error) {
+      perror("Error reading the input file");
+      result = -1;
+    }
+    closeInputFile(&input);
+  }
+  free(buffer);
+
+  if (result == -1) {
+    return -1;
+  }
+
+  const Alphabet* alphabet = modeAlphabet(encoder->mode);
+  for (int i = 0; i < alphabet->size; i++) {
+    histogram.counts[alphabet->characters[i]] += 1;
+  }
+
+  EncoderTable table;
+  buildEncoderTable(&histogram, alphabet, encoder->max_code_length, &table);
+
+  dictionary->mode = encoder->mode;
+  memcpy(dictionary->lengths, table.lengths, sizeof(dictionary->lengths));
+  dictionary->id = id != 0 ? id : dictionaryFingerprint(dictionary);
+  return 1;
+}
+
+/**
+ * Function Name: huffmanSaveDictionary
+ * Purpose: Writes a dictionary to a dictionary file
+ * Parameters:
+ *  - const HuffmanDictionary* dictionary: The dictionary
+ *  - const char* file_name: The dictionary file
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+int huffmanSaveDictionary(const HuffmanDictionary* dictionary, const char* file_name) {
+  if (checkDictionary(dictionary) == -1) {
+    return -1;
+  }
+
+  unsigned char data[DICTIONARY_HEADER_SIZE + 2 + 256 * 2] = { 0 };
+  memcpy(data, DICTIONARY_MAGIC, 4);
+  data[4] = DICTIONARY_VERSION;
+  data[5] = (unsigned char) dictionary->mode;
+  storeLittleEndian(data + 8, dictionary->id, DICTIONARY_ID_BYTES);
+
+  // the same (character, code length) pairs as the table of a block
+  size_t size = DICTIONARY_HEADER_SIZE + 2;
+  int code_count = 0;
+  for (int c = 0; c < 256; c++) {
+    if (dictionary->lengths[c] != 0) {
+      data[size++] = (unsigned char) c;
+      data[size++] = dictionary->lengths[c];
+      code_count += 1;
+    }
+  }
+  storeLittleEndian(data + DICTIONARY_HEADER_SIZE, (uint64_t) code_count, 2);
+
+  FILE* file = fopen(file_name, "wb");
+  if (file == NULL) {
+    perror(file_name);
+    return -1;
+  }
+  size_t written = fwrite(data, 1, size, file);
+  if (fclose(file) != 0 || written != size) {
+    perror("Error writing the dictionary file");
+    return -1;
+  }
+
+  return 1;
+}
+
+/**
+ * Function Name: huffmanLoadDictionary
+ * Purpose: Reads and validates a dictionary file
+ * Parameters:
+ *  - HuffmanDictionary* dictionary: Set to the dictionary in the file
+ *  - const char* file_name: The dictionary file
+ * Return Value:
+ *  - int: -1 if failed and 1 if successful
+ */
+int huffmanLoadDictionary(HuffmanDictionary* dictionary, const char* file_name) {
+  FILE* file = fopen(file_name, "rb");
+  if (file == NULL) {
+    perror(file_name);
+    return -1;
+  }
+
+  // one byte more than the largest dictionary, so a longer file is noticed
+  unsigned char data[DICTIONARY_HEADER_SIZE + 2 + 256 * 2 + 1];
+  size_t size = fread(data, 1, sizeof(data), file);
+  fclose(file);
+
+  if (size < DICTIONARY_HEADER_SIZE + 2 || memcmp(data, DICTIONARY_MAGIC, 4) != 0) {
+    fprintf(stderr, "%s is not a dictionary file\n", file_name);
+    return -1;
+  }
+  if (data[4] != DICTIONARY_VERSION) {
+    fprintf(stderr, "Unsupported dictionary version %d\n", data[4]);
+    return -1;
+  }
+
+  size_t code_count = (size_t) loadLittleEndian(data + DICTIONARY_HEADER_SIZE, 2);
+  if (code_count > 256 || size != DICTIONARY_HEADER_SIZE + 2 + code_count * 2) {
+    fprintf(stderr, "The dictionary file is damaged\n");
+    return -1;
+  }
+
+  dictionary->mode = data[5];
+  dictionary->id = (uint32_t) loadLittleEndian(data + 8, DICTIONARY_ID_BYTES);
+  memset(dictionary->lengths, 0, sizeof(dictionary->lengths));
+  const unsigned char* pairs = data + DICTIONARY_HEADER_SIZE + 2;
+  for (size_t i = 0; i < code_count; i++) {
+    dictionary->lengths[pairs[i * 2]] = pairs[i * 2 + 1];
+  }
+
+  return checkDictionary(dictionary);
+}
+
+/**
+ * Function Name: huffmanStatsClock
+ * Purpose: Reads the monotonic clock, it is not affected by changes to the time of day
+ * Parameters:
+ *  None
+ * Return Value:
+ *  - uint64_t: the time in nanoseconds
+ */
+uint64_t huffmanStatsClock(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * Function Name: huffmanWriteStats
+ * Purpose: Prints a summary of the statistics to stderr, with the share of every stage in the total time,
+ *  or writes them to a file as JSON
+ * Parameters:
+ *  - const HuffmanStats* stats: The statistics
+ *  - const char* file_name: "-" for the summary on stderr, the name of the JSON file otherwise
+ * Return Value:
+ *  - int: -1 if the file could not be written and 1 if successful
+ */
+int huffmanWriteStats(const HuffmanStats* stats, const char* file_name) {
+  if (strcmp(file_name, "-") == 0) {
+    double total = (double) stats->nanoseconds[HUFFMAN_STAGE_TOTAL];
+    fprintf(stderr, "%-16s %12s %8s\n", "stage", "ms", "share");
+    for (int stage = 0; stage < HUFFMAN_STAGE_COUNT; stage++) {
+      if (stats->nanoseconds[stage] == 0) {
+        continue;
+      }
+      double share = total > 0 ? 100.0 * (double) stats->nanoseconds[stage] / total : 0;
+      fprintf(stderr, "%-16s %12.3f %7.1f%%\n", STAGE_NAMES[stage], (double) stats->nanoseconds[stage] / 1e6, share);
+    }
+
+    double seconds = total / 1e9;
+    fprintf(stderr, "%llu inputs, %llu bytes in, %llu bytes out, %llu characters, %llu blocks, %llu new tables (%llu cached), %llu allocations\n",
+      (unsigned long long) stats->inputs, (unsigned long long) stats->input_bytes, (unsigned long long) stats->output_bytes,
+      (unsigned long long) stats->symbols, (unsigned long long) stats->blocks, (unsigned long long) stats->new_tables,
+      (unsigned long long) stats->cached_tables, (unsigned long long) stats->allocations);
+    if (seconds > 0) {
+      fprintf(stderr, "%.2f MB/s in, %.2f MB/s out\n", (double) stats->input_bytes / (1024.0 * 1024.0) / seconds,
+        (double) stats->output_bytes / (1024.0 * 1024.0) / seconds);
+    }
+    return 1;
+  }
+
+  FILE* file = fopen(file_name, "w");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open %s for writing\n", file_name);
+    return -1;
+  }
+
+  fprintf(file, "{\n  \"nanoseconds\": {\n");
+  for (int stage = 0; stage < HUFFMAN_STAGE_COUNT; stage++) {
+    fprintf(file, "    \"%s\": %llu%s\n", STAGE_NAMES[stage], (unsigned long long) stats->nanoseconds[stage],
+      stage + 1 < HUFFMAN_STAGE_COUNT ? "," : "");
+  }
+  fprintf(file, "  },\n");
+  fprintf(file, "  \"inputs\": %llu,\n", (unsigned long long) stats->inputs);
+  fprintf(file, "  \"input_bytes\": %llu,\n", (unsigned long long) stats->input_bytes);
+  fprintf(file, "  \"output_bytes\": %llu,\n", (unsigned long long) stats->output_bytes);
+  fprintf(file, "  \"symbols\": %llu,\n", (unsigned long long) stats->symbols);
+  fprintf(file, "  \"blocks\": %llu,\n", (unsigned long long) stats->blocks);
+  fprintf(file, "  \"new_tables\": %llu,\n", (unsigned long long) stats->new_tables);
+  fprintf(file, "  \"cached_tables\": %llu,\n", (unsigned long long) stats->cached_tables);
+  fprintf(file, "  \"allocations\": %llu\n", (unsigned long long) stats->allocations);
+  fprintf(file, "}\n");
+
+  int result = ferror(file) ? -1 : 1;
+  if (fclose(file) != 0 || result == -1) {
+    fprintf(stderr, "Failed to write %s\n", file_name);
+    return -1;
+  }
+  return 1;
+}
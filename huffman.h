@@ -0,0 +1,137 @@
+/**
+ * Description: Public interface of the huffman codec, built as libhuffman.a and libhuffman.so.
+ *  An encoder or decoder is a context that owns its thread pool and buffers, create one and use it for as many
+ *  inputs as needed. Different contexts can be used from different threads at the same time, a single context can not.
+ *  Every function that can fail returns -1 if it failed and 1 if it was successful, errors are printed to stderr.
+ *  The functions are documented where they are defined in huffman.c.
+ */
+
+#ifndef HUFFMAN_H
+#define HUFFMAN_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the characters that can be encoded, in the order they are written to frequency.txt
+#define HUFFMAN_ALPHABET " ,.0123456789abcdefghijklmnopqrstuvwxyz"
+
+// the text mode encodes HUFFMAN_ALPHABET only, the raw mode encodes every byte losslessly
+#define HUFFMAN_MODE_TEXT 0
+#define HUFFMAN_MODE_RAW 1
+
+// the most streams a block can be split into
+#define HUFFMAN_MAX_STREAMS 8
+
+// the stages a context times while its statistics are on. the stages that run on the thread pool
+// are summed over the threads, the side files are timed by the encode program itself
+#define HUFFMAN_STAGE_READ 0 // reading or mapping the input
+#define HUFFMAN_STAGE_NORMALIZE 1 // case folding and filtering the text
+#define HUFFMAN_STAGE_HISTOGRAM 2 // counting the characters
+#define HUFFMAN_STAGE_TABLE 3 // code lengths, encode tables and decode tables
+#define HUFFMAN_STAGE_PACK 4 // packing the bitstreams
+#define HUFFMAN_STAGE_PARSE 5 // validating the container, the block headers and the block index
+#define HUFFMAN_STAGE_DECODE 6 // decoding the bitstreams
+#define HUFFMAN_STAGE_WRITE 7 // writing the output
+#define HUFFMAN_STAGE_FREQUENCY_FILE 8 // writing frequency.txt
+#define HUFFMAN_STAGE_CODES_FILE 9 // building and writing codes.txt
+#define HUFFMAN_STAGE_TOTAL 10 // every call of the context from start to end
+#define HUFFMAN_STAGE_COUNT 11
+
+typedef struct HuffmanStats {
+  uint64_t nanoseconds[HUFFMAN_STAGE_COUNT]; // monotonic clock time of every stage
+  uint64_t inputs;
+  uint64_t input_bytes;
+  uint64_t output_bytes;
+  uint64_t symbols; // characters encoded or decoded
+  uint64_t blocks;
+  uint64_t new_tables; // blocks with a table of their own, the others reuse the table before them
+  uint64_t cached_tables; // new tables taken from the table cache instead of being built
+  uint64_t allocations; // buffers allocated or grown while coding, buffers kept by the context are not counted again
+} HuffmanStats;
+
+// a code length table trained on sample inputs, the id is stored in every block encoded with it
+typedef struct HuffmanDictionary {
+  uint32_t id;
+  int mode; // HUFFMAN_MODE_TEXT or HUFFMAN_MODE_RAW
+  uint8_t lengths[256]; // code length of every character, every character of the mode has a code
+} HuffmanDictionary;
+
+typedef struct HuffmanEncoder HuffmanEncoder;
+typedef struct HuffmanDecoder HuffmanDecoder;
+
+// ENCODER
+// a block_size or thread_count of 0 takes HUFFMAN_BLOCK_SIZE and HUFFMAN_THREADS, or the defaults
+HuffmanEncoder* createHuffmanEncoder(size_t block_size, int thread_count);
+void freeHuffmanEncoder(HuffmanEncoder* encoder);
+
+// codes are at most 15 bits, or HUFFMAN_MAX_CODE_LENGTH, unless this sets another limit from 6 to 19 bits
+int huffmanSetMaxCodeLength(HuffmanEncoder* encoder, int max_code_length);
+
+// the text mode is the default, the decoder reads the mode from the compressed data
+int huffmanSetMode(HuffmanEncoder* encoder, int mode);
+
+// every block is a single bitstream, or HUFFMAN_STREAMS, unless this sets from 1 to HUFFMAN_MAX_STREAMS.
+// 4 streams let the decoder work on 4 codes at once, for a few bytes per block
+int huffmanSetStreamCount(HuffmanEncoder* encoder, int stream_count);
+
+// the table cache is off, or HUFFMAN_TABLE_CACHE, unless this sets a margin from 0 to 100 percent or -1 for off.
+// a block then takes the table an earlier input built for a similar histogram if it costs at most margin percent more than its entropy
+int huffmanSetTableCache(HuffmanEncoder* encoder, int margin);
+
+// an output buffer of huffmanEncodeBound bytes is always large enough for huffmanEncodeBuffer
+size_t huffmanEncodeBound(const HuffmanEncoder* encoder, size_t input_size);
+int huffmanEncodeBuffer(HuffmanEncoder* encoder, const unsigned char* input, size_t input_size, unsigned char* output, size_t output_capacity, size_t* output_size);
+int huffmanEncodeFile(HuffmanEncoder* encoder, const char* input_name, FILE* output);
+
+// the frequency table of the last input and the codes for a frequency table, for frequency.txt and codes.txt
+const uint64_t* huffmanEncoderCounts(const HuffmanEncoder* encoder);
+int huffmanBuildCodes(const HuffmanEncoder* encoder, const uint64_t counts[], uint64_t codes[], uint8_t lengths[]);
+
+// with a dictionary the blocks are not counted and carry no table, they are encoded with the dictionary and the
+// encoder takes its mode. NULL goes back to a table for every block
+int huffmanEncoderSetDictionary(HuffmanEncoder* encoder, const HuffmanDictionary* dictionary);
+
+// statistics are off unless they are turned on, turning them on clears them. they add up over every input of the context
+void huffmanEncoderSetStats(HuffmanEncoder* encoder, int enabled);
+HuffmanStats* huffmanEncoderStats(HuffmanEncoder* encoder);
+
+// DECODER
+// a thread_count of 0 takes HUFFMAN_THREADS, or one thread per core
+HuffmanDecoder* createHuffmanDecoder(int thread_count);
+void freeHuffmanDecoder(HuffmanDecoder* decoder);
+
+// huffmanDecodedSize gives the exact output size huffmanDecodeBuffer needs
+int huffmanDecodedSize(const unsigned char* input, size_t input_size, size_t* decoded_size);
+int huffmanDecodeBuffer(HuffmanDecoder* decoder, const unsigned char* input, size_t input_size, unsigned char* output, size_t output_capacity, size_t* output_size);
+int huffmanDecodeFile(HuffmanDecoder* decoder, const char* input_name, const char* output_name);
+
+// blocks encoded with a dictionary are only decoded when the decoder has the dictionary with their id
+int huffmanDecoderSetDictionary(HuffmanDecoder* decoder, const HuffmanDictionary* dictionary);
+
+void huffmanDecoderSetStats(HuffmanDecoder* decoder, int enabled);
+HuffmanStats* huffmanDecoderStats(HuffmanDecoder* decoder);
+
+// DICTIONARY
+// trains a dictionary on sample files in the mode and with the maximum code length of the encoder, an id of 0
+// is derived from the table so the same samples always give the same id
+int huffmanTrainDictionary(const HuffmanEncoder* encoder, const char* const sample_names[], int sample_count, uint32_t id, HuffmanDictionary* dictionary);
+int huffmanSaveDictionary(const HuffmanDictionary* dictionary, const char* file_name);
+int huffmanLoadDictionary(HuffmanDictionary* dictionary, const char* file_name);
+
+// STATISTICS
+// the time on the monotonic clock in nanoseconds, for timing stages outside of the library
+uint64_t huffmanStatsClock(void);
+
+// "-" prints a summary to stderr, any other name gets the statistics as JSON
+int huffmanWriteStats(const HuffmanStats* stats, const char* file_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif